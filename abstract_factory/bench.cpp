@@ -0,0 +1,348 @@
+// Benchmarks and allocation budgets of the abstract_factory demo classes, reported by BenchmarkReporter.
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "platform.h"
+#include "ring_buffer.h"
+
+// Allocation budgets of the control paths; the run fails when one of them regresses.
+void check_allocations(WindowApplication *application) {
+    DiscardOutputSink sink;
+    setOutputSink(&sink);
+    const std::string_view longText = "Text that does not fit into the small string buffer";
+
+    expect_allocations("registry find", 0, [&] {
+        WindowApplicationRegistry::instance().find(OS::MacOS);
+        WindowApplicationRegistry::instance().find(USED_API);
+    });
+    expect_allocations("createButton/delete", 1, [&] {
+        delete application->createButton();
+    });
+    expect_allocations("acquireButton/release", 0, [&] {
+        application->acquireButton();
+    });
+    expect_allocations("acquireTextEdit/release", 0, [&] {
+        application->acquireTextEdit();
+    });
+    expect_allocations("createButtons(500)", 1, [&] {
+        application->createButtons(500);
+    });
+    expect_allocations("createTextEdits(500)/setText", 1, [&] {
+        ControlBatch<TextEdit> batch = application->createTextEdits(500);
+        for (TextEdit *textEdit: batch.controls()) {
+            textEdit->setText("Hello OS");
+        }
+    });
+    expect_allocations("createTextEdit/setText/delete", 1, [&] {
+        TextEdit *control = application->createTextEdit();
+        control->setText("Hello OS");
+        delete control;
+    });
+
+    TextEdit *control = application->createTextEdit();
+    expect_allocations("setText(string_view), steady state", 0, [&] {
+        control->setText(longText);
+    });
+    expect_allocations("setText(string&&)", 1, [&] {
+        control->setText(std::string(longText));
+    });
+
+    std::vector<TextEdit *> controls(16, control);
+    std::vector<std::string_view> texts(controls.size(), longText);
+    expect_allocations("setTexts, steady state", 0, [&] {
+        setTexts(controls, texts);
+    });
+    delete control;
+
+    std::vector<std::unique_ptr<Button>> buttons;
+    buttons.emplace_back(application->createButton());
+    buttons.emplace_back(application->createButton());
+    ButtonClickBatch clicks;
+    expect_allocations("ButtonClickBatch click/dispatch, steady state", 0, [&] {
+        for (std::size_t i = 0; i < 64; ++i) {
+            clicks.click(buttons[i % buttons.size()].get());
+        }
+        clicks.dispatch();
+    });
+    setOutputSink(nullptr);
+}
+
+// Producer threads create buttons and hand them over through a RingBuffer; this thread clicks them in batches.
+void benchmark_handoff(WindowApplication *application, std::size_t buttonsPerProducer) {
+    DiscardOutputSink sink;
+    setOutputSink(&sink);
+    std::vector<std::unique_ptr<Button>> batch(64);
+    std::size_t maxProducers = std::max(std::thread::hardware_concurrency(), 2u);
+    for (std::size_t producers = 1; producers <= maxProducers; ++producers) {
+        RingBuffer<std::unique_ptr<Button>, 1024> queue;
+        std::size_t buttons = producers * buttonsPerProducer;
+        benchmark("createButton handoff/buttonClick, " + std::to_string(producers) + " producer(s)", buttons, [&] {
+            std::vector<std::jthread> threads;
+            for (std::size_t i = 0; i < producers; ++i) {
+                threads.emplace_back([&] {
+                    for (std::size_t j = 0; j < buttonsPerProducer; ++j) {
+                        queue.push(std::unique_ptr<Button>(application->createButton()));
+                    }
+                });
+            }
+            for (std::size_t received = 0; received < buttons;) {
+                std::size_t count = queue.popBatch(batch);
+                for (std::size_t i = 0; i < count; ++i) {
+                    batch[i]->buttonClick();
+                    batch[i].reset();
+                }
+                received += count;
+            }
+        });
+    }
+    setOutputSink(nullptr);
+}
+
+// Resolving the factory per document: a switch creating one against registry lookups.
+void benchmark_registry(std::size_t documents) {
+    const OS platforms[] = {OS::Windows, OS::MacOS};
+    WindowApplicationRegistry &registry = WindowApplicationRegistry::instance();
+    std::size_t found = 0;
+    benchmark("factory per document, switch + new/delete", documents, [&] {
+        for (std::size_t i = 0; i < documents; ++i) {
+            std::unique_ptr<WindowApplication> application;
+            switch (platforms[i % 2]) {
+                case OS::Windows:
+                    application = std::make_unique<WindowsWindowApplication>();
+                    break;
+                case OS::MacOS:
+                    application = std::make_unique<MacOSWindowApplication>();
+                    break;
+                default:
+                    break;
+            }
+            found += application != nullptr;
+        }
+    });
+    benchmark("factory per document, registry, same platform", documents, [&] {
+        for (std::size_t i = 0; i < documents; ++i) {
+            found += registry.find(OS::Windows) != nullptr;
+        }
+    });
+    benchmark("factory per document, registry, alternating platforms", documents, [&] {
+        for (std::size_t i = 0; i < documents; ++i) {
+            found += registry.find(platforms[i % 2]) != nullptr;
+        }
+    });
+    BenchmarkReporter::instance().note() << "  (" << found << " factories resolved)" << std::endl;
+}
+
+// A form view of many controls: created one by one against in one block, then clicked through.
+void benchmark_bulk(WindowApplication *application, std::size_t controlsPerView, std::size_t views) {
+    DiscardOutputSink sink;
+    setOutputSink(&sink);
+    std::vector<Button *> buttons(controlsPerView);
+    benchmark("createButton x" + std::to_string(controlsPerView) + "/buttonClick/delete", views * controlsPerView, [&] {
+        for (std::size_t view = 0; view < views; ++view) {
+            for (Button *&button: buttons) {
+                button = application->createButton();
+            }
+            for (Button *button: buttons) {
+                button->buttonClick();
+            }
+            for (Button *button: buttons) {
+                delete button;
+            }
+        }
+    });
+    benchmark("createButtons(" + std::to_string(controlsPerView) + ")/buttonClick", views * controlsPerView, [&] {
+        for (std::size_t view = 0; view < views; ++view) {
+            ControlBatch<Button> batch = application->createButtons(controlsPerView);
+            for (Button *button: batch.controls()) {
+                button->buttonClick();
+            }
+        }
+    });
+    benchmark("createTextEdits(" + std::to_string(controlsPerView) + ")/setText", views * controlsPerView, [&] {
+        for (std::size_t view = 0; view < views; ++view) {
+            ControlBatch<TextEdit> batch = application->createTextEdits(controlsPerView);
+            for (TextEdit *textEdit: batch.controls()) {
+                textEdit->setText("Hello OS");
+            }
+        }
+    });
+    setOutputSink(nullptr);
+}
+
+// A replay of clicks on the buttons of both platforms: one virtual buttonClick() and one log line per click
+// against a ButtonClickBatch dispatching them per concrete type.
+void benchmark_clicks(WindowApplication *application, std::size_t clicksPerBatch, std::size_t batches) {
+    std::vector<std::unique_ptr<Button>> buttons;
+    for (OS platform: {OS::Windows, OS::MacOS}) {
+        WindowApplication *factory = WindowApplicationRegistry::instance().find(platform);
+        for (std::size_t i = 0; i < 8; ++i) {
+            buttons.emplace_back((factory ? factory : application)->createButton());
+        }
+    }
+    std::vector<Button *> replay(clicksPerBatch);
+    for (std::size_t i = 0; i < replay.size(); ++i) {
+        replay[i] = buttons[(i * 7) % buttons.size()].get();
+    }
+
+    benchmark_output("buttonClick per event", clicksPerBatch * batches, [&] {
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            for (Button *button: replay) {
+                button->buttonClick();
+            }
+        }
+    });
+    ButtonClickBatch clicks;
+    benchmark_output("ButtonClickBatch x" + std::to_string(clicksPerBatch), clicksPerBatch * batches, [&] {
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            for (Button *button: replay) {
+                clicks.click(button);
+            }
+            clicks.dispatch();
+        }
+    });
+}
+
+void benchmark_code(WindowApplication *application) {
+    const std::size_t events = 100000;
+
+    Button *button = application->createButton();
+    TextEdit *textEdit = application->createTextEdit();
+
+    benchmark_output("buttonClick", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            button->buttonClick();
+        }
+    });
+    benchmark_output("setText", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            textEdit->setText("Hello OS");
+        }
+    });
+
+    delete button;
+    delete textEdit;
+
+    {
+        DiscardOutputSink sink;
+        setOutputSink(&sink);
+        benchmark("virtual createButton/buttonClick/delete", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                Button *control = application->createButton();
+                control->buttonClick();
+                delete control;
+            }
+        });
+        benchmark("virtual createTextEdit/setText/getText/delete", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                TextEdit *control = application->createTextEdit();
+                control->setText("Hello OS");
+                sink.write(control->getText());
+                delete control;
+            }
+        });
+#if PLATFORM_WINDOWS || PLATFORM_MACOS
+        WindowApplicationT<USED_API> staticApplication;
+        benchmark("static createButton/buttonClick", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                staticApplication.createButton().buttonClick();
+            }
+        });
+        benchmark("static createTextEdit/setText/getText", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                auto control = staticApplication.createTextEdit();
+                control.setText("Hello OS");
+                sink.write(control.getText());
+            }
+        });
+#endif
+        setOutputSink(nullptr);
+    }
+
+    {
+        DiscardOutputSink sink;
+        setOutputSink(&sink);
+        const std::string_view text = "Text that does not fit into the small string buffer";
+        TextEdit *control = application->createTextEdit();
+        control->setText(text);
+        benchmark("setText(string_view), steady state", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                control->setText(text);
+            }
+        });
+        benchmark("setText(string&&)", events, [&] {
+            for (std::size_t i = 0; i < events; ++i) {
+                control->setText(std::string(text));
+            }
+        });
+        delete control;
+
+        std::vector<TextEdit *> controls;
+        for (std::size_t i = 0; i < 100; ++i) {
+            controls.push_back(application->createTextEdit());
+        }
+        std::vector<std::string_view> texts(controls.size(), text);
+        setTexts(controls, texts);
+        benchmark("setTexts, steady state", events, [&] {
+            for (std::size_t i = 0; i < events / controls.size(); ++i) {
+                setTexts(controls, texts);
+            }
+        });
+        for (TextEdit *edit: controls) {
+            delete edit;
+        }
+        setOutputSink(nullptr);
+    }
+
+    benchmark("createButton/delete", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            delete application->createButton();
+        }
+    });
+    benchmark("acquireButton/release", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            application->acquireButton();
+        }
+    });
+    benchmark("createTextEdit/delete", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            delete application->createTextEdit();
+        }
+    });
+    benchmark("acquireTextEdit/release", events, [&] {
+        for (std::size_t i = 0; i < events; ++i) {
+            application->acquireTextEdit();
+        }
+    });
+
+    benchmark_handoff(application, events);
+    benchmark_registry(events * 10);
+    benchmark_bulk(application, 500, events / 500);
+    benchmark_clicks(application, 1000, events * 10 / 1000);
+
+#ifdef INLINE_STRING_STATS
+    InlineString<TEXT_EDIT_CAPACITY>::stats().report(BenchmarkReporter::instance().note(), TEXT_EDIT_CAPACITY);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    WindowApplication *app = WindowApplicationRegistry::instance().find(USED_API);
+    if (!app) {
+        outputSink().writeLine("None of platforms is chosen!");
+        outputSink().flush();
+        return 1;
+    }
+
+    BenchmarkReporter::instance().configure(argc, argv);
+    check_allocations(app);
+    if (!BenchmarkReporter::instance().allocationChecksOnly()) {
+        benchmark_code(app);
+    }
+    return BenchmarkReporter::instance().finish();
+}
@@ -32,125 +32,11 @@
  *
  */
 
-#include <iostream>
-#include <string>
+#include "output_sink.h"
+#include "platform.h"
 
-class Button {
-public:
-    virtual void buttonClick() = 0;
-
-    virtual ~Button() = default;
-
-};
-
-class TextEdit {
-protected:
-    std::string m_text;
-public:
-    virtual const std::string &getText() = 0;
-
-    virtual void setText(std::string text) = 0;
-
-    virtual ~TextEdit() = default;
-
-};
-
-
-class WindowsButton : public Button {
-public:
-    void buttonClick() override {
-        //Windows native handling
-        std::cout << "Windows button was clicked" << std::endl;
-    }
-};
-
-class WindowsTextEdit : public TextEdit {
-public:
-    const std::string &getText() override {
-
-        //Windows native handling
-        return m_text;
-    }
-
-    void setText(std::string text) override {
-        //Windows native handling
-        m_text = text;
-        std::cout << "Windows TextEdit text set to " << "'" << m_text << "'" << std::endl;
-    }
-};
-
-
-class MacOSButton : public Button {
-public:
-    void buttonClick() override {
-        //MacOS native handling
-        std::cout << "MacOS button was clicked" << std::endl;
-    }
-};
-
-class MacOSTextEdit : public TextEdit {
-public:
-    const std::string &getText() override {
-        //MacOS native handling
-        return m_text;
-    }
-
-    void setText(std::string text) override {
-        //MacOS native handling
-        m_text = text;
-        std::cout << "MacOS TextEdit text set to " << "'" << m_text << "'" << std::endl;
-    }
-};
-
-
-class WindowApplication {
-public:
-    virtual Button *createButton() = 0;
-
-    virtual TextEdit *createTextEdit() = 0;
-
-    virtual ~WindowApplication() = default;
-};
-
-class WindowsWindowApplication : public WindowApplication {
-public:
-    Button *createButton() override {
-        return new WindowsButton;
-    }
-
-    TextEdit *createTextEdit() override {
-        return new WindowsTextEdit;
-    }
-};
-
-class MacOSWindowApplication : public WindowApplication {
-public:
-    Button *createButton() override {
-        return new MacOSButton;
-    }
-
-    TextEdit *createTextEdit() override {
-        return new MacOSTextEdit;
-    }
-};
-
-enum class OS {
-    Windows,
-    MacOS,
-    None
-};
-
-#define PLATFORM_WINDOWS 1
-#define PLATFORM_MACOS 0
-
-
-#if PLATFORM_WINDOWS
-const OS USED_API = OS::Windows;
-#elif PLATFORM_MACOS
-const OS USED_API = OS::MacOS;
-#else
-const OS USED_API = OS::None;
-#endif
+// 1 uses WindowApplicationT<USED_API> when a platform is chosen, 0 selects a WindowApplication at runtime.
+#define STATIC_DISPATCH 1
 
 void client_code(WindowApplication *application) {
     Button *button = application->createButton();
@@ -158,28 +44,37 @@ void client_code(WindowApplication *application) {
 
     button->buttonClick();
     textEdit->setText("Hello OS");
-    std::cout << "Text edit have text -> " << textEdit->getText() << std::endl;
+    outputSink().writeLine("Text edit have text -> ", textEdit->getText());
 
     delete button;
     delete textEdit;
 }
 
+template<StaticWindowApplication Application>
+void client_code(Application &application) {
+    auto button = application.createButton();
+    auto textEdit = application.createTextEdit();
+
+    button.buttonClick();
+    textEdit.setText("Hello OS");
+    outputSink().writeLine("Text edit have text -> ", textEdit.getText());
+}
+
 int main() {
-    WindowApplication *app;
-    switch (USED_API) {
-        case OS::Windows:
-            app = new WindowsWindowApplication;
-            break;
-        case OS::MacOS:
-            app = new MacOSWindowApplication;
-            break;
-        default:
-            std::cout << "None of platforms is chosen!";
-            return 1;
+#if STATIC_DISPATCH && (PLATFORM_WINDOWS || PLATFORM_MACOS)
+    WindowApplicationT<USED_API> app;
+    client_code(app);
+    outputSink().flush();
+    return 0;
+#else
+    WindowApplication *app = WindowApplicationRegistry::instance().find(USED_API);
+    if (!app) {
+        outputSink().writeLine("None of platforms is chosen!");
+        outputSink().flush();
+        return 1;
     }
-
     client_code(app);
-
-    delete app;
+    outputSink().flush();
     return 0;
+#endif
 }
@@ -0,0 +1,16 @@
+#pragma once
+
+// The platform the demo and its benchmarks are built for.
+
+#include "window_application.h"
+
+#define PLATFORM_WINDOWS 1
+#define PLATFORM_MACOS 0
+
+#if PLATFORM_WINDOWS
+constexpr OS USED_API = OS::Windows;
+#elif PLATFORM_MACOS
+constexpr OS USED_API = OS::MacOS;
+#else
+constexpr OS USED_API = OS::None;
+#endif
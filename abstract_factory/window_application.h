@@ -0,0 +1,572 @@
+#pragma once
+
+// The Abstract Factory pattern classes of the abstract_factory demo: the controls, their pools and the
+// runtime and compile-time platform factories.
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "inline_string.h"
+#include "instrumentation.h"
+#include "output_sink.h"
+
+#ifndef TEXT_EDIT_CAPACITY
+#define TEXT_EDIT_CAPACITY 48
+#endif
+
+class Button {
+public:
+    virtual void buttonClick() = 0;
+
+    // Same click, logged to the given sink instead of outputSink().
+    virtual void buttonClick(OutputSink &sink) = 0;
+
+    // Clicks all the buttons, which share this button's concrete type, appending their log lines to log
+    // instead of writing each. Concrete buttons override it to loop without a virtual call per click.
+    virtual void clickAll(std::span<Button *const> buttons, std::string &log) {
+        StringOutputSink sink(log);
+        for (Button *button: buttons) {
+            button->buttonClick(sink);
+        }
+    }
+
+    virtual ~Button() = default;
+
+};
+
+class TextEdit {
+protected:
+    InlineString<TEXT_EDIT_CAPACITY> m_text;
+public:
+    virtual std::string_view getText() = 0;
+
+    // Copies into the storage the control already has.
+    virtual void setText(std::string_view text) = 0;
+
+    // Takes over the caller's storage.
+    virtual void setText(std::string &&text) = 0;
+
+    void setText(const std::string &text) {
+        setText(std::string_view(text));
+    }
+
+    void setText(const char *text) {
+        setText(std::string_view(text));
+    }
+
+    // Forgets the text but keeps its storage, so a pooled control starts empty.
+    void recycle() {
+        m_text.clear();
+    }
+
+    virtual ~TextEdit() = default;
+
+};
+
+// Sets texts[i] on textEdits[i], reusing the storage of every control.
+inline void setTexts(std::span<TextEdit *const> textEdits, std::span<const std::string_view> texts) {
+    std::size_t count = std::min(textEdits.size(), texts.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        textEdits[i]->setText(texts[i]);
+    }
+}
+
+template<typename Product>
+class PoolDeleter {
+    void (*m_release)(Product *) = nullptr;
+
+public:
+    PoolDeleter() = default;
+
+    explicit PoolDeleter(void (*release)(Product *)) : m_release(release) {
+    }
+
+    void operator()(Product *product) const {
+        m_release(product);
+    }
+};
+
+// Owns a pooled control and gives it back to its pool on destruction.
+template<typename Product>
+using PoolHandle = std::unique_ptr<Product, PoolDeleter<Product>>;
+
+using ButtonHandle = PoolHandle<Button>;
+using TextEditHandle = PoolHandle<TextEdit>;
+
+// Per-thread free list of released Concrete controls. A control goes back to the list of the thread
+// that releases it, and the lists delete their controls when the thread exits.
+template<typename Concrete>
+class ObjectPool {
+    struct FreeList {
+        std::vector<Concrete *> objects;
+
+        ~FreeList() {
+            for (Concrete *object: objects) {
+                delete object;
+            }
+        }
+    };
+
+    static FreeList &freeList() {
+        thread_local FreeList list;
+        return list;
+    }
+
+    template<typename Product>
+    static void release(Product *product) {
+        Concrete *object = static_cast<Concrete *>(product);
+        if constexpr (requires { object->recycle(); }) {
+            object->recycle();
+        }
+        freeList().objects.push_back(object);
+    }
+
+public:
+    template<typename Product>
+    static PoolHandle<Product> acquire() {
+        FreeList &list = freeList();
+        Concrete *object;
+        if (list.objects.empty()) {
+            object = new Concrete;
+        } else {
+            object = list.objects.back();
+            list.objects.pop_back();
+        }
+        return PoolHandle<Product>(object, PoolDeleter<Product>(&release<Product>));
+    }
+};
+
+
+// Controls created together: the objects sit next to each other in one allocation, followed by the
+// pointers handed out through controls(). Destroying the batch destroys the controls.
+template<typename Product>
+class ControlBatch {
+    void *m_block = nullptr;
+    Product **m_controls = nullptr;
+    std::size_t m_size = 0;
+    void (*m_destroy)(void *, std::size_t) = nullptr;
+
+    template<typename Concrete>
+    static constexpr std::size_t pointersOffset(std::size_t count) {
+        std::size_t objects = count * sizeof(Concrete);
+        return (objects + alignof(Product *) - 1) / alignof(Product *) * alignof(Product *);
+    }
+
+    template<typename Concrete>
+    static void destroy(void *block, std::size_t count) {
+        std::destroy_n(static_cast<Concrete *>(block), count);
+        ::operator delete(block);
+    }
+
+public:
+    ControlBatch() = default;
+
+    template<typename Concrete>
+    static ControlBatch create(std::size_t count) {
+        static_assert(std::is_base_of_v<Product, Concrete> && alignof(Concrete) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        ControlBatch batch;
+        if (count == 0) {
+            return batch;
+        }
+        std::size_t offset = pointersOffset<Concrete>(count);
+        void *block = ::operator new(offset + count * sizeof(Product *));
+        auto *objects = static_cast<Concrete *>(block);
+        try {
+            std::uninitialized_value_construct_n(objects, count);
+        } catch (...) {
+            ::operator delete(block);
+            throw;
+        }
+        auto **controls = reinterpret_cast<Product **>(static_cast<std::byte *>(block) + offset);
+        for (std::size_t i = 0; i < count; ++i) {
+            controls[i] = objects + i;
+        }
+        batch.m_block = block;
+        batch.m_controls = controls;
+        batch.m_size = count;
+        batch.m_destroy = &destroy<Concrete>;
+        return batch;
+    }
+
+    ControlBatch(ControlBatch &&other) noexcept
+            : m_block(std::exchange(other.m_block, nullptr)), m_controls(std::exchange(other.m_controls, nullptr)),
+              m_size(std::exchange(other.m_size, 0)), m_destroy(std::exchange(other.m_destroy, nullptr)) {
+    }
+
+    ControlBatch &operator=(ControlBatch &&other) noexcept {
+        std::swap(m_block, other.m_block);
+        std::swap(m_controls, other.m_controls);
+        std::swap(m_size, other.m_size);
+        std::swap(m_destroy, other.m_destroy);
+        return *this;
+    }
+
+    ~ControlBatch() {
+        if (m_block) {
+            m_destroy(m_block, m_size);
+        }
+    }
+
+    std::span<Product *const> controls() const {
+        return {m_controls, m_size};
+    }
+
+    Product &operator[](std::size_t index) const {
+        return *m_controls[index];
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+};
+
+class WindowsButton final : public Button {
+    static constexpr std::string_view clickLog = "Windows button was clicked";
+
+public:
+    void buttonClick() override {
+        buttonClick(outputSink());
+    }
+
+    void buttonClick(OutputSink &sink) override {
+        //Windows native handling
+        sink.writeLine(clickLog);
+    }
+
+    void clickAll(std::span<Button *const> buttons, std::string &log) override {
+        for (std::size_t i = 0; i < buttons.size(); ++i) {
+            //Windows native handling
+            log.append(clickLog).push_back('\n');
+        }
+    }
+};
+
+class WindowsTextEdit final : public TextEdit {
+public:
+    std::string_view getText() override {
+
+        //Windows native handling
+        return m_text;
+    }
+
+    using TextEdit::setText;
+
+    void setText(std::string_view text) override {
+        //Windows native handling
+        m_text.assign(text);
+        textChanged();
+    }
+
+    void setText(std::string &&text) override {
+        //Windows native handling
+        m_text.assign(std::move(text));
+        textChanged();
+    }
+
+private:
+    void textChanged() {
+        outputSink().writeLine("Windows TextEdit text set to '", m_text, "'");
+    }
+};
+
+
+class MacOSButton final : public Button {
+    static constexpr std::string_view clickLog = "MacOS button was clicked";
+
+public:
+    void buttonClick() override {
+        buttonClick(outputSink());
+    }
+
+    void buttonClick(OutputSink &sink) override {
+        //MacOS native handling
+        sink.writeLine(clickLog);
+    }
+
+    void clickAll(std::span<Button *const> buttons, std::string &log) override {
+        for (std::size_t i = 0; i < buttons.size(); ++i) {
+            //MacOS native handling
+            log.append(clickLog).push_back('\n');
+        }
+    }
+};
+
+class MacOSTextEdit final : public TextEdit {
+public:
+    std::string_view getText() override {
+        //MacOS native handling
+        return m_text;
+    }
+
+    using TextEdit::setText;
+
+    void setText(std::string_view text) override {
+        //MacOS native handling
+        m_text.assign(text);
+        textChanged();
+    }
+
+    void setText(std::string &&text) override {
+        //MacOS native handling
+        m_text.assign(std::move(text));
+        textChanged();
+    }
+
+private:
+    void textChanged() {
+        outputSink().writeLine("MacOS TextEdit text set to '", m_text, "'");
+    }
+};
+
+
+// Queues clicks and runs them grouped by the concrete button type: one virtual clickAll() per group and
+// one write of all the log lines. Clicks of one type keep their order; different types are not interleaved.
+// Not thread-safe.
+class ButtonClickBatch {
+    struct Group {
+        const std::type_info *type;
+        std::vector<Button *> buttons;
+    };
+
+    std::vector<Group> m_groups;
+    std::size_t m_lastGroup = 0;
+    std::string m_log;
+
+public:
+    void click(Button *button) {
+        const std::type_info &type = typeid(*button);
+        if (m_lastGroup >= m_groups.size() || *m_groups[m_lastGroup].type != type) {
+            auto found = std::find_if(m_groups.begin(), m_groups.end(), [&type](const Group &group) {
+                return *group.type == type;
+            });
+            if (found == m_groups.end()) {
+                found = m_groups.insert(m_groups.end(), Group{&type, {}});
+            }
+            m_lastGroup = static_cast<std::size_t>(found - m_groups.begin());
+        }
+        m_groups[m_lastGroup].buttons.push_back(button);
+    }
+
+    // Runs the queued clicks; the queues and the log keep their storage for the next batch.
+    void dispatch() {
+        m_log.clear();
+        for (Group &group: m_groups) {
+            if (!group.buttons.empty()) {
+                group.buttons.front()->clickAll(group.buttons, m_log);
+                group.buttons.clear();
+            }
+        }
+        if (!m_log.empty()) {
+            outputSink().write(m_log);
+        }
+    }
+
+    std::size_t pending() const {
+        std::size_t pending = 0;
+        for (const Group &group: m_groups) {
+            pending += group.buttons.size();
+        }
+        return pending;
+    }
+};
+
+class WindowApplication {
+public:
+    virtual Button *createButton() = 0;
+
+    virtual TextEdit *createTextEdit() = 0;
+
+    // Same controls as create*(), recycled through per-thread pools instead of new/delete.
+    virtual ButtonHandle acquireButton() = 0;
+
+    virtual TextEditHandle acquireTextEdit() = 0;
+
+    // Creates count controls in one contiguous block.
+    virtual ControlBatch<Button> createButtons(std::size_t count) = 0;
+
+    virtual ControlBatch<TextEdit> createTextEdits(std::size_t count) = 0;
+
+    virtual ~WindowApplication() = default;
+};
+
+class WindowsWindowApplication : public WindowApplication {
+public:
+    Button *createButton() override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::createButton");
+        return new WindowsButton;
+    }
+
+    TextEdit *createTextEdit() override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::createTextEdit");
+        return new WindowsTextEdit;
+    }
+
+    ButtonHandle acquireButton() override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::acquireButton");
+        return ObjectPool<WindowsButton>::acquire<Button>();
+    }
+
+    TextEditHandle acquireTextEdit() override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::acquireTextEdit");
+        return ObjectPool<WindowsTextEdit>::acquire<TextEdit>();
+    }
+
+    ControlBatch<Button> createButtons(std::size_t count) override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::createButtons");
+        return ControlBatch<Button>::create<WindowsButton>(count);
+    }
+
+    ControlBatch<TextEdit> createTextEdits(std::size_t count) override {
+        INSTRUMENT_SCOPE("WindowsWindowApplication::createTextEdits");
+        return ControlBatch<TextEdit>::create<WindowsTextEdit>(count);
+    }
+};
+
+class MacOSWindowApplication : public WindowApplication {
+public:
+    Button *createButton() override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::createButton");
+        return new MacOSButton;
+    }
+
+    TextEdit *createTextEdit() override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::createTextEdit");
+        return new MacOSTextEdit;
+    }
+
+    ButtonHandle acquireButton() override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::acquireButton");
+        return ObjectPool<MacOSButton>::acquire<Button>();
+    }
+
+    TextEditHandle acquireTextEdit() override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::acquireTextEdit");
+        return ObjectPool<MacOSTextEdit>::acquire<TextEdit>();
+    }
+
+    ControlBatch<Button> createButtons(std::size_t count) override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::createButtons");
+        return ControlBatch<Button>::create<MacOSButton>(count);
+    }
+
+    ControlBatch<TextEdit> createTextEdits(std::size_t count) override {
+        INSTRUMENT_SCOPE("MacOSWindowApplication::createTextEdits");
+        return ControlBatch<TextEdit>::create<MacOSTextEdit>(count);
+    }
+};
+
+enum class OS {
+    Windows,
+    MacOS,
+    None
+};
+
+// The runtime factories by platform, in a flat array indexed by the OS value. The built-in platforms
+// are registered up front; a plugin registers its factory under a further OS value, e.g.
+// static_cast<OS>(3). A slot is written once and the registry owns its factory, so a thread can keep
+// the last factory it looked up without it ever going stale.
+class WindowApplicationRegistry {
+public:
+    static constexpr std::size_t maxPlatforms = 16;
+
+private:
+    std::atomic<WindowApplication *> m_applications[maxPlatforms]{};
+    std::unique_ptr<WindowApplication> m_owned[maxPlatforms];
+    std::mutex m_mutex;
+
+    WindowApplicationRegistry() {
+        add(OS::Windows, std::make_unique<WindowsWindowApplication>());
+        add(OS::MacOS, std::make_unique<MacOSWindowApplication>());
+    }
+
+public:
+    static WindowApplicationRegistry &instance() {
+        static WindowApplicationRegistry registry;
+        return registry;
+    }
+
+    // False, leaving the registry as it was, when the slot is out of range or already taken.
+    bool add(OS platform, std::unique_ptr<WindowApplication> application) {
+        auto index = static_cast<std::size_t>(platform);
+        std::lock_guard lock(m_mutex);
+        if (index >= maxPlatforms || m_owned[index]) {
+            return false;
+        }
+        m_owned[index] = std::move(application);
+        m_applications[index].store(m_owned[index].get(), std::memory_order_release);
+        return true;
+    }
+
+    // The factory of the platform, or nullptr when none is registered for it.
+    WindowApplication *find(OS platform) {
+        struct Cached {
+            OS platform;
+            WindowApplication *application;
+        };
+        thread_local Cached cached{OS::None, nullptr};
+        if (cached.platform == platform && cached.application) {
+            return cached.application;
+        }
+        auto index = static_cast<std::size_t>(platform);
+        if (index >= maxPlatforms) {
+            return nullptr;
+        }
+        WindowApplication *application = m_applications[index].load(std::memory_order_acquire);
+        if (application) {
+            cached = {platform, application};
+        }
+        return application;
+    }
+};
+
+template<OS Platform>
+struct PlatformControls;
+
+template<>
+struct PlatformControls<OS::Windows> {
+    using ButtonType = WindowsButton;
+    using TextEditType = WindowsTextEdit;
+};
+
+template<>
+struct PlatformControls<OS::MacOS> {
+    using ButtonType = MacOSButton;
+    using TextEditType = MacOSTextEdit;
+};
+
+// Factory of a platform fixed at compile time. The controls are returned by value as their final
+// classes, so the compiler resolves and can inline every call made on them.
+template<OS Platform>
+class WindowApplicationT {
+public:
+    using ButtonType = typename PlatformControls<Platform>::ButtonType;
+    using TextEditType = typename PlatformControls<Platform>::TextEditType;
+
+    ButtonType createButton() {
+        INSTRUMENT_SCOPE("WindowApplicationT::createButton");
+        return {};
+    }
+
+    TextEditType createTextEdit() {
+        INSTRUMENT_SCOPE("WindowApplicationT::createTextEdit");
+        return {};
+    }
+};
+
+template<typename Application>
+concept StaticWindowApplication = requires(Application &application) {
+    { application.createButton() } -> std::derived_from<Button>;
+    { application.createTextEdit() } -> std::derived_from<TextEdit>;
+};
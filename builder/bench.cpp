@@ -0,0 +1,669 @@
+// Benchmarks and allocation budgets of the builder demo classes, reported by BenchmarkReporter.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "ring_buffer.h"
+#include "task.h"
+#include "window_builder.h"
+#include "window_snapshot.h"
+
+template<typename Builder>
+void benchmark_heap(const char *name, WindowCreationManager *manager, std::size_t frames, std::size_t windowsPerFrame) {
+    Builder builder;
+    manager->setBuilder(&builder);
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+                manager->createWindowWithTitle("Benchmark title");
+                builder.getWindow();
+            }
+        }
+    });
+}
+
+template<typename Builder>
+void benchmark_static(const char *name, std::size_t frames, std::size_t windowsPerFrame) {
+    Builder builder;
+    StaticWindowCreationManager<Builder> manager;
+    manager.setBuilder(&builder);
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+                manager.createWindowWithTitle("Benchmark title");
+                builder.getWindow();
+            }
+        }
+    });
+}
+
+template<typename Builder, typename Window>
+void benchmark_arena(const char *name, WindowCreationManager *manager, std::size_t frames, std::size_t windowsPerFrame) {
+    WindowArena<Window> arena;
+    Builder builder(&arena);
+    manager->setBuilder(&builder);
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+                manager->createWindowWithTitle("Benchmark title");
+                builder.getWindow();
+            }
+            arena.releaseAll();
+        }
+    });
+}
+
+template<typename Builder, typename Window>
+void benchmark_batch(const char *name, WindowCreationManager *manager, std::size_t frames, std::size_t windowsPerFrame) {
+    std::vector<std::string_view> titles(windowsPerFrame, "Benchmark title");
+    std::vector<Window> windows(windowsPerFrame);
+    Builder builder;
+    builder.setOutput(windows);
+    manager->setBuilder(&builder);
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            manager->createWindows(titles);
+        }
+    });
+}
+
+template<typename Builder, typename Window>
+void benchmark_parallel(const char *name, std::size_t frames, std::size_t windowsPerFrame) {
+    std::vector<std::string_view> titles(windowsPerFrame, "Benchmark title");
+    std::vector<Window> windows(windowsPerFrame);
+    std::size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::size_t threads = 1; threads <= maxThreads; ++threads) {
+        ParallelWindowCreationService<Builder, Window> service(threads);
+        std::string label = std::string(name) + ", " + std::to_string(threads) + " thread(s)";
+        benchmark(label, frames * windowsPerFrame, [&] {
+            for (std::size_t frame = 0; frame < frames; ++frame) {
+                service.createWindows(titles, windows);
+            }
+        });
+    }
+}
+
+// The mutex-protected baseline for the RingBuffer handoff: the same bounded push()/popBatch() interface.
+template<typename T, std::size_t Capacity>
+class MutexQueue {
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_values;
+
+public:
+    void push(T value) {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this] {
+            return m_values.size() < Capacity;
+        });
+        m_values.push_back(std::move(value));
+        m_notEmpty.notify_one();
+    }
+
+    std::size_t popBatch(std::span<T> output) {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] {
+            return !m_values.empty();
+        });
+        std::size_t count = std::min(output.size(), m_values.size());
+        std::move(m_values.begin(), m_values.begin() + count, output.begin());
+        m_values.erase(m_values.begin(), m_values.begin() + count);
+        m_notFull.notify_all();
+        return count;
+    }
+};
+
+template<typename Window>
+struct TimedWindow {
+    WindowPtr<Window> window;
+    std::chrono::steady_clock::time_point pushed;
+};
+
+// Stamps each window the manager pushes, so the consumer can measure how long it waited in the queue.
+template<typename Window, typename Queue>
+struct TimestampingQueue {
+    Queue &queue;
+
+    void push(WindowPtr<Window> window) {
+        queue.push({std::move(window), std::chrono::steady_clock::now()});
+    }
+};
+
+// Producers build windows with their own builder and manager and push them; this thread pops them in batches.
+template<typename Builder, typename Window, template<typename, std::size_t> typename Queue>
+void benchmark_handoff(const char *name, std::size_t windowsPerProducer) {
+    std::vector<std::string_view> titles(windowsPerProducer, "Benchmark title");
+    std::size_t maxProducers = std::max(std::thread::hardware_concurrency(), 2u);
+    std::vector<std::int64_t> latencies;
+    std::vector<TimedWindow<Window>> batch(64);
+    for (std::size_t producers = 1; producers <= maxProducers; ++producers) {
+        Queue<TimedWindow<Window>, 1024> queue;
+        TimestampingQueue<Window, decltype(queue)> timestamping{queue};
+        std::size_t windows = producers * windowsPerProducer;
+        latencies.assign(windows, 0);
+        std::string label = std::string(name) + ", " + std::to_string(producers) + " producer(s)";
+        benchmark(label, windows, [&] {
+            std::vector<std::jthread> threads;
+            for (std::size_t i = 0; i < producers; ++i) {
+                threads.emplace_back([&] {
+                    Builder builder;
+                    WindowCreationManager manager;
+                    manager.createWindows(builder, titles, timestamping);
+                });
+            }
+            for (std::size_t received = 0; received < windows;) {
+                std::size_t count = queue.popBatch(batch);
+                auto now = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < count; ++i) {
+                    latencies[received++] = (now - batch[i].pushed) / std::chrono::nanoseconds(1);
+                    batch[i].window.reset();
+                }
+            }
+        });
+        std::sort(latencies.begin(), latencies.end());
+        BenchmarkReporter::instance().note() << "  queue latency p50 " << latencies[windows / 2] << " ns, p99 "
+                                             << latencies[windows * 99 / 100] << " ns, p99.9 "
+                                             << latencies[windows * 999 / 1000] << " ns" << std::endl;
+    }
+}
+
+template<typename Builder>
+Task<std::size_t> open_windows(RunLoop &loop, std::span<const std::string_view> titles) {
+    std::size_t opened = 0;
+    for (std::string_view title: titles) {
+        auto window = co_await WindowCreationManager::createWindowAsync<Builder>(loop, std::string(title));
+        opened += window != nullptr;
+    }
+    co_return opened;
+}
+
+// Windows built by coroutines on a run loop, with a callback posted per window standing in for startup I/O.
+template<typename Builder>
+void benchmark_async(const char *name, std::size_t windows) {
+    std::vector<std::string_view> titles(windows, "Benchmark title");
+    RunLoop loop;
+    std::size_t callbacks = 0;
+    std::size_t opened = 0;
+    benchmark(name, windows, [&] {
+        for (std::size_t i = 0; i < windows; ++i) {
+            loop.post([&callbacks] {
+                ++callbacks;
+            });
+        }
+        opened = loop.run(open_windows<Builder>(loop, titles));
+        loop.runUntilIdle();
+    });
+    BenchmarkReporter::instance().note() << "  (" << opened << " windows, " << callbacks
+                                         << " callbacks)" << std::endl;
+}
+
+// Serializes a batch, maps the snapshot back and restores products from it without running the builder steps.
+template<typename Builder, typename Window>
+void benchmark_snapshot(const char *name, WindowCreationManager *manager, std::size_t windows) {
+    std::vector<std::string_view> titles(windows, "Benchmark title");
+    WindowSnapshotWriter writer;
+    SerializingWindowBuilder<Builder> builder(&writer);
+    manager->setBuilder(&builder);
+    benchmark(std::string(name) + ", serialize", windows, [&] {
+        writer.clear();
+        manager->createWindows(titles);
+    });
+
+    std::string path = (std::filesystem::temp_directory_path() / "somanypatterns_snapshot.bin").string();
+    writer.save(path);
+    std::optional<MappedFile> file = MappedFile::open(path);
+    std::optional<WindowSnapshot> snapshot;
+    benchmark(std::string(name) + ", map + validate", windows, [&] {
+        file = MappedFile::open(path);
+        snapshot = WindowSnapshot::view(file->bytes());
+    });
+    if (!expect_result(std::string(name) + " snapshot window count", snapshot && snapshot->size() == windows)) {
+        return;
+    }
+    expect_result(std::string(name) + " snapshot structure",
+                  snapshot->structure(0) == renderStructure(Builder::kinds, titles[0]));
+
+    std::vector<Window> restored(windows);
+    benchmark(std::string(name) + ", restore", windows, [&] {
+        for (std::size_t i = 0; i < snapshot->size(); ++i) {
+            snapshot->restore(i, restored[i]);
+        }
+    });
+    BenchmarkReporter::instance().note() << "  (" << file->bytes().size() / windows << " bytes per window)"
+                                         << std::endl;
+    std::filesystem::remove(path);
+}
+
+template<typename Builder>
+void benchmark_table(const char *name, WindowCreationManager *manager, std::size_t frames, std::size_t windowsPerFrame) {
+    std::vector<std::string_view> titles(windowsPerFrame, "Benchmark title");
+    WindowTable table;
+    WindowTableBuilder<Builder> builder(&table);
+    manager->setBuilder(&builder);
+    std::size_t macOSWindows = 0;
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            table.clear();
+            manager->createWindows(titles);
+            for (NativeWindowKind kind: table.nativeWindows()) {
+                macOSWindows += kind == NativeWindowKind::StandardMacOS;
+            }
+        }
+    });
+    BenchmarkReporter::instance().note() << "  (" << macOSWindows << " MacOS windows scanned)" << std::endl;
+}
+
+template<typename Builder, typename Window>
+void benchmark_print(const char *name, WindowCreationManager *manager, std::size_t windows) {
+    Builder builder;
+    manager->setBuilder(&builder);
+    manager->createWindowWithTitle("Benchmark title");
+    WindowPtr<Window> window = builder.getWindow();
+    benchmark_output(name, windows, [&] {
+        for (std::size_t i = 0; i < windows; ++i) {
+            window->printStructure();
+        }
+    });
+}
+
+// Streaming straight to the sink against building a product and printing it.
+template<typename Builder>
+void benchmark_streaming(const char *name, WindowCreationManager *manager, std::size_t windows) {
+    benchmark_output(std::string(name) + ", build + printStructure", windows, [&] {
+        Builder builder;
+        manager->setBuilder(&builder);
+        for (std::size_t i = 0; i < windows; ++i) {
+            manager->createWindowWithTitle("Benchmark title");
+            builder.getWindow()->printStructure();
+        }
+    });
+    benchmark_output(std::string(name) + ", StreamingWindowBuilder", windows, [&] {
+        StreamingWindowBuilder<Builder> builder(outputSink());
+        manager->setBuilder(&builder);
+        for (std::size_t i = 0; i < windows; ++i) {
+            manager->createWindowWithTitle("Benchmark title");
+        }
+    });
+}
+
+// A title change by replaying the whole construction against patching only the title.
+template<typename Builder, typename Window>
+void benchmark_update_title(const char *name, WindowCreationManager *manager, std::size_t updates) {
+    const std::string_view titles[] = {"Inbox (1)", "Inbox (12)"};
+    Builder builder;
+    manager->setBuilder(&builder);
+    manager->createWindowWithTitle(titles[0]);
+    WindowPtr<Window> window = builder.getWindow();
+    benchmark(std::string(name) + ", reset + createWindowWithTitle", updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) {
+            manager->createWindowWithTitle(titles[i % 2]);
+            window = builder.getWindow();
+        }
+    });
+    benchmark(std::string(name) + ", updateTitle", updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) {
+            WindowCreationManager::updateTitle(*window, titles[i % 2]);
+        }
+    });
+
+    StructureText structure(Builder::kinds, titles[0]);
+    benchmark(std::string(name) + ", structure rendered again", updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) {
+            structure.render(Builder::kinds, titles[i % 2]);
+        }
+    });
+    benchmark(std::string(name) + ", structure title segment patched", updates, [&] {
+        for (std::size_t i = 0; i < updates; ++i) {
+            WindowCreationManager::updateTitle(structure, titles[i % 2]);
+        }
+    });
+    expect_result(std::string(name) + " patched structure",
+                  structure.view() == renderStructure(Builder::kinds, titles[(updates - 1) % 2]));
+}
+
+// Products with their own title copies against fragment IDs into a shared title table, for a session
+// with many windows but few distinct titles.
+template<typename Builder, typename Window>
+void benchmark_interning(const char *name, WindowCreationManager *manager, std::size_t windows) {
+    std::vector<std::string> distinct;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        distinct.push_back("Document " + std::to_string(i));
+    }
+    std::vector<std::string_view> titles;
+    for (std::size_t i = 0; i < windows; ++i) {
+        titles.push_back(distinct[(i * 7919) % distinct.size()]);
+    }
+
+    std::vector<Window> products(windows);
+    Builder builder;
+    builder.setOutput(products);
+    manager->setBuilder(&builder);
+    benchmark(std::string(name) + ", products", windows, [&] {
+        manager->createWindows(titles);
+    });
+
+    TitleTable table;
+    std::vector<InternedWindow> interned(windows);
+    InterningWindowBuilder<Builder> interningBuilder(&table);
+    interningBuilder.setOutput(interned);
+    manager->setBuilder(&interningBuilder);
+    benchmark(std::string(name) + ", interned", windows, [&] {
+        manager->createWindows(titles);
+    });
+    expect_result(std::string(name) + " interned structure", interned[0].structure(table) == products[0].structure());
+
+    std::size_t equalProducts = 0;
+    benchmark(std::string(name) + ", products equality", windows - 1, [&] {
+        for (std::size_t i = 1; i < windows; ++i) {
+            equalProducts += products[i].kinds == products[i - 1].kinds &&
+                             products[i].getTitle() == products[i - 1].getTitle();
+        }
+    });
+    std::size_t equalInterned = 0;
+    benchmark(std::string(name) + ", interned equality", windows - 1, [&] {
+        for (std::size_t i = 1; i < windows; ++i) {
+            equalInterned += interned[i] == interned[i - 1];
+        }
+    });
+    expect_result(std::string(name) + " interned equality", equalProducts == equalInterned);
+
+    std::size_t productBytes = sizeof(Window) * windows;
+    for (const Window &product: products) {
+        productBytes += product.title.onHeap() ? product.title.size() + 1 : 0;
+    }
+    BenchmarkReporter::instance().note() << "  (" << productBytes / windows << " bytes per product, "
+                                         << (sizeof(InternedWindow) * windows + table.bytes()) / windows
+                                         << " bytes per interned window with " << table.size() << " titles)"
+                                         << std::endl;
+}
+
+template<typename Builder, typename Window>
+void benchmark_title_lengths(const char *name, WindowCreationManager *manager, std::size_t frames,
+                             std::size_t windowsPerFrame) {
+    const std::string_view lengths[] = {
+            "Short",
+            "Window with a medium title",
+            "Fenêtre avec un titre localisé assez long",
+            "Fenster mit einem sehr langen lokalisierten Titel, der überläuft"
+    };
+    std::vector<std::string_view> titles;
+    for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+        titles.push_back(lengths[i % std::size(lengths)]);
+    }
+    std::vector<Window> windows(windowsPerFrame);
+    Builder builder;
+    builder.setOutput(windows);
+    manager->setBuilder(&builder);
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            manager->createWindows(titles);
+        }
+    });
+}
+
+template<typename Builder, typename Window>
+void benchmark_cache(const char *name, WindowCreationManager *manager, std::size_t frames,
+                     std::size_t windowsPerFrame) {
+    const std::string_view popular[] = {"Inbox", "Drafts", "Sent", "Settings", "New Window"};
+    std::vector<std::string> titles;
+    std::size_t repeated = 0;
+    for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+        titles.push_back(i % 5 == 4 ? "Document " + std::to_string(i) : std::string(popular[repeated++ % 5]));
+    }
+
+    Builder builder;
+    manager->setBuilder(&builder);
+    benchmark(std::string(name) + ", rebuild", frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (const std::string &title: titles) {
+                manager->createWindowWithTitle(title);
+                builder.getWindow();
+            }
+        }
+    });
+
+    // The unique titles of a frame are evicted long before the next frame asks for them again.
+    WindowCache<Window> cache(64 * 1024);
+    benchmark(std::string(name) + ", cached", frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (const std::string &title: titles) {
+                cache.createWindowWithTitle(builder, title);
+            }
+        }
+    });
+    BenchmarkReporter::instance().note() << "  " << cache.hits() << " hits, " << cache.misses() << " misses, "
+                                         << cache.evictions() << " evictions, " << cache.bytes() << " bytes cached"
+                                         << std::endl;
+}
+
+template<typename Builder>
+void benchmark_template(const char *name, WindowCreationManager *manager, std::size_t frames,
+                        std::size_t windowsPerFrame) {
+    Builder builder;
+    manager->setBuilder(&builder);
+    manager->prepareTemplateWindow();
+    benchmark(name, frames * windowsPerFrame, [&] {
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            for (std::size_t i = 0; i < windowsPerFrame; ++i) {
+                manager->createWindowFromTemplate("Benchmark title");
+                builder.getWindow();
+            }
+        }
+    });
+}
+
+// Cost of the single steps through the virtual interface, on a window that is already allocated.
+template<typename Builder>
+void benchmark_steps(const char *name, std::size_t steps) {
+    Builder concrete;
+    WindowBuilder *builder = &concrete;
+    builder->createNativeWindow();
+    const std::string prefix = name;
+    benchmark(prefix + " createNativeWindow", steps, [&] {
+        for (std::size_t i = 0; i < steps; ++i) {
+            builder->createNativeWindow();
+        }
+    });
+    benchmark(prefix + " addMenubar", steps, [&] {
+        for (std::size_t i = 0; i < steps; ++i) {
+            builder->addMenubar();
+        }
+    });
+    benchmark(prefix + " setTitle", steps, [&] {
+        for (std::size_t i = 0; i < steps; ++i) {
+            builder->setTitle("Benchmark title");
+        }
+    });
+    benchmark(prefix + " setDefaultBackgroundColor", steps, [&] {
+        for (std::size_t i = 0; i < steps; ++i) {
+            builder->setDefaultBackgroundColor();
+        }
+    });
+}
+
+// Allocation budgets of the construction paths; the run fails when one of them regresses.
+template<typename Builder, typename Window>
+void check_allocations(const char *name, WindowCreationManager *manager) {
+    const std::string prefix = name;
+    const std::string_view longTitle = "A window title that is too long for the inline title buffer";
+    Builder builder;
+    manager->setBuilder(&builder);
+    expect_allocations(prefix + " createWindowWithTitle + reset", 1, [&] {
+        manager->createWindowWithTitle("Custom title");
+        builder.reset();
+    });
+    expect_allocations(prefix + " createWindowWithTitle + reset, long title", 2, [&] {
+        manager->createWindowWithTitle(longTitle);
+        builder.reset();
+    });
+    expect_allocations(prefix + " createWindowWithTitle + getWindow", 1, [&] {
+        manager->createWindowWithTitle("Custom title");
+        builder.getWindow();
+    });
+
+    WindowArena<Window> arena;
+    Builder arenaBuilder(&arena);
+    manager->setBuilder(&arenaBuilder);
+    expect_allocations(prefix + " arena createWindowWithTitle + reset", 0, [&] {
+        manager->createWindowWithTitle("Custom title");
+        arenaBuilder.reset();
+        arena.releaseAll();
+    });
+    manager->prepareTemplateWindow();
+    expect_allocations(prefix + " arena createWindowFromTemplate", 0, [&] {
+        manager->createWindowFromTemplate("Custom title");
+        arenaBuilder.getWindow();
+        arena.releaseAll();
+    });
+    manager->createWindowFromTemplate("Custom title");
+    expect_result(prefix + " createWindowFromTemplate structure",
+                  arenaBuilder.getWindow()->structure() == renderStructure(Builder::kinds, "Custom title"));
+    arena.releaseAll();
+    manager->setBuilder(&builder);
+    expect_allocations(prefix + " prepareTemplateWindow", 0, [&] {
+        manager->prepareTemplateWindow();
+    });
+
+    manager->createWindowWithTitle("Custom title");
+    WindowPtr<Window> window = builder.getWindow();
+    StructureText structure(Builder::kinds, "Custom title");
+    expect_allocations(prefix + " updateTitle", 0, [&] {
+        WindowCreationManager::updateTitle(*window, "Changed title");
+        WindowCreationManager::updateTitle(structure, "Changed title, longer");
+    });
+    StructureText unrendered;
+    WindowCreationManager::updateTitle(unrendered, "Changed title");
+    expect_result(prefix + " updateTitle of an unrendered structure",
+                  unrendered.view() == renderStructure(WindowKinds{}, "Changed title"));
+    WindowCreationManager::updateTitle(*window, longTitle);
+    WindowCreationManager::updateTitle(*window, "Changed title");
+    expect_allocations(prefix + " copy of a window whose title was long", 0, [&] {
+        Window copy = *window;
+    });
+
+    DiscardOutputSink sink;
+    StreamingWindowBuilder<Builder> streamingBuilder(sink);
+    manager->setBuilder(&streamingBuilder);
+    expect_allocations(prefix + " streaming createWindowWithTitle", 0, [&] {
+        manager->createWindowWithTitle(longTitle);
+    });
+    std::string streamed;
+    StringOutputSink streamedSink(streamed);
+    StreamingWindowBuilder<Builder> abandoningBuilder(streamedSink);
+    manager->setBuilder(&abandoningBuilder);
+    manager->prepareTemplateWindow();
+    abandoningBuilder.cloneTemplate();
+    streamed.clear();
+    manager->createWindowWithTitle("Custom title");
+    expect_result(prefix + " streaming window after an abandoned clone",
+                  streamed == renderStructure(Builder::kinds, "Custom title") + "\n");
+
+    RunLoop loop;
+    expect_allocations(prefix + " createWindowAsync on a run loop", 2, [&] {
+        loop.run(WindowCreationManager::createWindowAsync<Builder>(loop, "Custom title"));
+    });
+
+    std::vector<std::string_view> titles(64, "Custom title");
+    std::vector<Window> windows(titles.size());
+    builder.setOutput(windows);
+    manager->setBuilder(&builder);
+    expect_allocations(prefix + " createWindows into storage", 0, [&] {
+        manager->createWindows(titles);
+    });
+    WindowCache<Window> cache(64 * 1024);
+    cache.createWindowWithTitle(builder, "Cached title");
+    expect_result(prefix + " cache miss keeps the batch output",
+                  builder.output().data() == windows.data() && builder.output().size() == windows.size());
+    builder.setOutput(std::span(windows).first(1));
+    bool rejected = false;
+    try {
+        manager->createWindows(titles);
+    } catch (const std::out_of_range &) {
+        rejected = true;
+    }
+    expect_result(prefix + " createWindows into short storage", rejected);
+    builder.setOutput(windows);
+
+    WindowTable table;
+    WindowTableBuilder<Builder> tableBuilder(&table);
+    manager->setBuilder(&tableBuilder);
+    expect_allocations(prefix + " table createWindows, steady state", 0, [&] {
+        table.clear();
+        manager->createWindows(titles);
+    });
+}
+
+void benchmark_code(WindowCreationManager *manager) {
+    const std::size_t frames = 100;
+    const std::size_t windowsPerFrame = 10000;
+
+    benchmark_steps<WindowsWindowBuilder>("WindowsWindowBuilder", frames * windowsPerFrame);
+    benchmark_steps<MacOSWindowBuilder>("MacOSWindowBuilder", frames * windowsPerFrame);
+
+    benchmark_heap<WindowsWindowBuilder>("WindowsWindowBuilder new/delete", manager, frames, windowsPerFrame);
+    benchmark_arena<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder arena", manager, frames,
+                                                         windowsPerFrame);
+    benchmark_static<WindowsWindowBuilder>("WindowsWindowBuilder static manager", frames, windowsPerFrame);
+    benchmark_template<WindowsWindowBuilder>("WindowsWindowBuilder template clone", manager, frames, windowsPerFrame);
+    benchmark_batch<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder batch", manager, frames,
+                                                         windowsPerFrame);
+    benchmark_parallel<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder parallel", frames,
+                                                            windowsPerFrame);
+    benchmark_handoff<WindowsWindowBuilder, WindowsWindow, RingBuffer>("WindowsWindowBuilder handoff, ring buffer",
+                                                                       windowsPerFrame * 10);
+    benchmark_handoff<WindowsWindowBuilder, WindowsWindow, MutexQueue>("WindowsWindowBuilder handoff, mutex queue",
+                                                                       windowsPerFrame * 10);
+    benchmark_async<WindowsWindowBuilder>("WindowsWindowBuilder createWindowAsync on a run loop", windowsPerFrame * 10);
+    benchmark_snapshot<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder snapshot", manager, windowsPerFrame);
+    benchmark_table<WindowsWindowBuilder>("WindowsWindowBuilder table + scan", manager, frames, windowsPerFrame);
+    benchmark_print<WindowsWindowBuilder, WindowsWindow>("WindowsWindow printStructure", manager, windowsPerFrame);
+    benchmark_streaming<WindowsWindowBuilder>("WindowsWindowBuilder", manager, windowsPerFrame);
+    benchmark_interning<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder 1000 distinct titles", manager,
+                                                             windowsPerFrame * 10);
+    benchmark_update_title<WindowsWindowBuilder, WindowsWindow>("WindowsWindow title change", manager,
+                                                                frames * windowsPerFrame);
+    benchmark_heap<MacOSWindowBuilder>("MacOSWindowBuilder new/delete", manager, frames, windowsPerFrame);
+    benchmark_arena<MacOSWindowBuilder, MacOSWindow>("MacOSWindowBuilder arena", manager, frames, windowsPerFrame);
+    benchmark_static<MacOSWindowBuilder>("MacOSWindowBuilder static manager", frames, windowsPerFrame);
+    benchmark_template<MacOSWindowBuilder>("MacOSWindowBuilder template clone", manager, frames, windowsPerFrame);
+    benchmark_batch<MacOSWindowBuilder, MacOSWindow>("MacOSWindowBuilder batch", manager, frames, windowsPerFrame);
+    benchmark_parallel<MacOSWindowBuilder, MacOSWindow>("MacOSWindowBuilder parallel", frames, windowsPerFrame);
+    benchmark_table<MacOSWindowBuilder>("MacOSWindowBuilder table + scan", manager, frames, windowsPerFrame);
+    benchmark_print<MacOSWindowBuilder, MacOSWindow>("MacOSWindow printStructure", manager, windowsPerFrame);
+    benchmark_title_lengths<MacOSWindowBuilder, MacOSWindow>("MacOSWindowBuilder batch, mixed title lengths", manager,
+                                                             frames, windowsPerFrame);
+    benchmark_cache<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder 80% repeated titles", manager,
+                                                         frames, windowsPerFrame);
+
+#ifdef INLINE_STRING_STATS
+    WindowTitle::stats().report(BenchmarkReporter::instance().note(), WindowTitle::inlineCapacity);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    WindowCreationManager *manager = new WindowCreationManager;
+    BenchmarkReporter::instance().configure(argc, argv);
+    check_allocations<WindowsWindowBuilder, WindowsWindow>("WindowsWindowBuilder", manager);
+    check_allocations<MacOSWindowBuilder, MacOSWindow>("MacOSWindowBuilder", manager);
+    if (!BenchmarkReporter::instance().allocationChecksOnly()) {
+        benchmark_code(manager);
+    }
+    int status = BenchmarkReporter::instance().finish();
+    delete manager;
+    return status;
+}
@@ -21,143 +21,16 @@
  */
 
 
-#include <iostream>
-
-class MacOSWindow {
-public:
-    std::string structure;
-
-    void printStructure() {
-        std::cout << structure << std::endl;
-    }
-};
-
-class WindowsWindow {
-public:
-    std::string structure;
-
-    void printStructure() {
-        std::cout << structure << std::endl;
-    }
-};
-
-class WindowBuilder {
-public:
-    virtual void createNativeWindow() = 0;
-
-    virtual void addMenubar() = 0;
-
-    virtual void setTitle(std::string title) = 0;
-
-    virtual void setDefaultBackgroundColor() = 0;
-};
-
-class MacOSWindowBuilder : public WindowBuilder {
-    MacOSWindow *window;
-
-public:
-    MacOSWindowBuilder() {
-        reset();
-    }
-
-    void reset() {
-        window = new MacOSWindow;
-
-    }
-
-    ~MacOSWindowBuilder() {
-        delete window;
-    }
-
-    void createNativeWindow() override {
-        window->structure += "Window: Standard MacOS; ";
-    }
-
-    void addMenubar() override {
-        window->structure += "Menubar: MacOS default; ";
-    }
-
-    void setTitle(std::string title) override {
-        window->structure += "Window title: " + title + ";";
-    }
-
-    void setDefaultBackgroundColor() override {
-        window->structure += "Background color: MacOS default; ";
-    }
-
-    MacOSWindow *getWindow() {
-        return window;
-    }
-};
-
-class WindowsWindowBuilder : public WindowBuilder {
-    WindowsWindow *window;
-public:
-    WindowsWindowBuilder() {
-        reset();
-    }
-
-    void reset() {
-        window = new WindowsWindow;
-    }
-
-    ~WindowsWindowBuilder() {
-        delete window;
-    }
-
-    void createNativeWindow() override {
-        window->structure += "Window: Standard Windows; ";
-    }
-
-    void addMenubar() override {
-        window->structure += "Menubar: Windows default; ";
-    }
-
-    void setTitle(std::string title) override {
-        window->structure += "Window title: " + title + ";";
-    }
-
-    void setDefaultBackgroundColor() override {
-        window->structure += "Background color: Windows default; ";
-    }
-
-    WindowsWindow *getWindow() {
-        return window;
-    }
-};
-
-class WindowCreationManager {
-    WindowBuilder *m_builder;
-
-public:
-    void setBuilder(WindowBuilder *builder) {
-        m_builder = builder;
-    }
-
-    void createDefaultWindow() {
-        m_builder->createNativeWindow();
-        m_builder->addMenubar();
-        m_builder->setTitle("New Window");
-        m_builder->setDefaultBackgroundColor();
-    }
-
-    void createWindowWithTitle(std::string title) {
-        m_builder->createNativeWindow();
-        m_builder->addMenubar();
-        m_builder->setTitle(title);
-        m_builder->setDefaultBackgroundColor();
-    }
-};
+#include "output_sink.h"
+#include "window_builder.h"
 
 void client_code(WindowCreationManager *manager) {
     {
         WindowsWindowBuilder *builder = new WindowsWindowBuilder;
         manager->setBuilder(builder);
         manager->createDefaultWindow();
-        WindowsWindow *window = builder->getWindow();
+        WindowPtr<WindowsWindow> window = builder->getWindow();
         window->printStructure();
-        delete window;
-        builder->reset();
         manager->createWindowWithTitle("New title");
         window = builder->getWindow();
         window->printStructure();
@@ -168,10 +41,8 @@ void client_code(WindowCreationManager *manager) {
         MacOSWindowBuilder *builder = new MacOSWindowBuilder;
         manager->setBuilder(builder);
         manager->createDefaultWindow();
-        MacOSWindow *window = builder->getWindow();
+        WindowPtr<MacOSWindow> window = builder->getWindow();
         window->printStructure();
-        delete window;
-        builder->reset();
         manager->createWindowWithTitle("New title");
         window = builder->getWindow();
         window->printStructure();
@@ -182,6 +53,7 @@ void client_code(WindowCreationManager *manager) {
 int main() {
     WindowCreationManager *manager = new WindowCreationManager;
     client_code(manager);
+    outputSink().flush();
     delete manager;
     return 0;
 }
@@ -0,0 +1,1388 @@
+#pragma once
+
+// The Builder pattern classes of the builder demo: the window products, the platform builders, the creation
+// managers and the arena, batch, table, parallel, queued, asynchronous and cached ways of building windows.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "inline_string.h"
+#include "instrumentation.h"
+#include "output_sink.h"
+#include "task.h"
+
+#ifndef WINDOW_TITLE_CAPACITY
+#define WINDOW_TITLE_CAPACITY 48
+#endif
+
+using WindowTitle = InlineString<WINDOW_TITLE_CAPACITY>;
+
+template<typename Window>
+class WindowArena {
+    static constexpr std::size_t windowsPerBlock = 256;
+
+    struct Block {
+        alignas(Window) std::byte storage[windowsPerBlock * sizeof(Window)];
+    };
+
+    std::vector<std::unique_ptr<Block>> m_blocks;
+    std::size_t m_size = 0;
+
+    Window *at(std::size_t index) {
+        return std::launder(reinterpret_cast<Window *>(
+                m_blocks[index / windowsPerBlock]->storage + (index % windowsPerBlock) * sizeof(Window)));
+    }
+
+public:
+    WindowArena() = default;
+
+    WindowArena(const WindowArena &) = delete;
+
+    WindowArena &operator=(const WindowArena &) = delete;
+
+    ~WindowArena() {
+        releaseAll();
+    }
+
+    Window *create() {
+        if (m_size == m_blocks.size() * windowsPerBlock) {
+            m_blocks.emplace_back(new Block);
+        }
+        std::byte *place = m_blocks[m_size / windowsPerBlock]->storage + (m_size % windowsPerBlock) * sizeof(Window);
+        Window *window = new(place) Window;
+        ++m_size;
+        return window;
+    }
+
+    // Destroys every window created since the last call; the blocks are kept for reuse.
+    void releaseAll() {
+        for (std::size_t i = 0; i < m_size; ++i) {
+            std::destroy_at(at(i));
+        }
+        m_size = 0;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+};
+
+// Deletes heap windows. Arena windows are left to the arena, which destroys them in releaseAll().
+template<typename Window>
+class WindowDeleter {
+    WindowArena<Window> *m_arena = nullptr;
+
+public:
+    WindowDeleter() = default;
+
+    explicit WindowDeleter(WindowArena<Window> *arena) : m_arena(arena) {
+    }
+
+    void operator()(Window *window) const {
+        if (!m_arena) {
+            delete window;
+        }
+    }
+};
+
+template<typename Window>
+using WindowPtr = std::unique_ptr<Window, WindowDeleter<Window>>;
+
+template<typename Window>
+WindowPtr<Window> makeWindow(WindowArena<Window> *arena) {
+    return arena ? WindowPtr<Window>(arena->create(), WindowDeleter<Window>(arena)) : WindowPtr<Window>(new Window);
+}
+
+enum class BuildStep {
+    NativeWindow,
+    Menubar,
+    Title,
+    DefaultBackgroundColor
+};
+
+inline constexpr BuildStep windowSteps[] = {
+        BuildStep::NativeWindow,
+        BuildStep::Menubar,
+        BuildStep::Title,
+        BuildStep::DefaultBackgroundColor
+};
+
+// The steps that do not depend on the title, built once for template windows.
+inline constexpr BuildStep templateSteps[] = {
+        BuildStep::NativeWindow,
+        BuildStep::Menubar,
+        BuildStep::DefaultBackgroundColor
+};
+
+// Whether prepare() announces a template window, which has no title step.
+inline bool describesTemplate(std::span<const BuildStep> steps) {
+    return std::find(steps.begin(), steps.end(), BuildStep::Title) == steps.end();
+}
+
+inline constexpr std::string_view defaultWindowTitle = "New Window";
+inline constexpr std::string_view titlePrefix = "Window title: ";
+inline constexpr std::string_view titleSuffix = ";";
+
+enum class NativeWindowKind : std::uint8_t {
+    None,
+    StandardMacOS,
+    StandardWindows
+};
+
+enum class MenubarKind : std::uint8_t {
+    None,
+    MacOSDefault,
+    WindowsDefault
+};
+
+enum class BackgroundColorKind : std::uint8_t {
+    None,
+    MacOSDefault,
+    WindowsDefault
+};
+
+struct WindowKinds {
+    NativeWindowKind nativeWindow = NativeWindowKind::None;
+    MenubarKind menubar = MenubarKind::None;
+    BackgroundColorKind defaultBackgroundColor = BackgroundColorKind::None;
+
+    bool operator==(const WindowKinds &) const = default;
+};
+
+constexpr std::string_view fragment(NativeWindowKind kind) {
+    switch (kind) {
+        case NativeWindowKind::StandardMacOS:
+            return "Window: Standard MacOS; ";
+        case NativeWindowKind::StandardWindows:
+            return "Window: Standard Windows; ";
+        default:
+            return {};
+    }
+}
+
+constexpr std::string_view fragment(MenubarKind kind) {
+    switch (kind) {
+        case MenubarKind::MacOSDefault:
+            return "Menubar: MacOS default; ";
+        case MenubarKind::WindowsDefault:
+            return "Menubar: Windows default; ";
+        default:
+            return {};
+    }
+}
+
+constexpr std::string_view fragment(BackgroundColorKind kind) {
+    switch (kind) {
+        case BackgroundColorKind::MacOSDefault:
+            return "Background color: MacOS default; ";
+        case BackgroundColorKind::WindowsDefault:
+            return "Background color: Windows default; ";
+        default:
+            return {};
+    }
+}
+
+constexpr std::size_t structureSize(const WindowKinds &kinds, std::string_view title) {
+    return fragment(kinds.nativeWindow).size() + fragment(kinds.menubar).size() + titlePrefix.size() + title.size() +
+           titleSuffix.size() + fragment(kinds.defaultBackgroundColor).size();
+}
+
+// Renders the textual structure of a window from its parts in one exactly reserved string.
+inline std::string renderStructure(const WindowKinds &kinds, std::string_view title) {
+    std::string structure;
+    structure.reserve(structureSize(kinds, title));
+    structure.append(fragment(kinds.nativeWindow)).append(fragment(kinds.menubar))
+            .append(titlePrefix).append(title).append(titleSuffix)
+            .append(fragment(kinds.defaultBackgroundColor));
+    return structure;
+}
+
+inline void writeStructure(OutputSink &sink, const WindowKinds &kinds, std::string_view title) {
+    sink.writeLine(fragment(kinds.nativeWindow), fragment(kinds.menubar), titlePrefix, title, titleSuffix,
+                   fragment(kinds.defaultBackgroundColor));
+}
+
+inline std::size_t titleChars(std::span<const std::string_view> titles) {
+    std::size_t chars = 0;
+    for (std::string_view title: titles) {
+        chars += title.size();
+    }
+    return chars;
+}
+
+// Makes room for extra more elements, at least doubling the capacity when it has to grow, so that a stream
+// of small batches appended one after another stays amortized linear.
+template<typename Container>
+void reserveAppend(Container &container, std::size_t extra) {
+    std::size_t needed = container.size() + extra;
+    if (needed > container.capacity()) {
+        container.reserve(std::max(needed, 2 * container.capacity()));
+    }
+}
+
+// A rendered structure that remembers which step produced which segment, so a title change patches
+// the title segment in place instead of rendering the whole text again.
+class StructureText {
+    static constexpr std::size_t segments = 4;
+
+    std::string m_text;
+    // End offset of each step's segment, in BuildStep order, which is also the order in the text.
+    std::uint32_t m_segmentEnds[segments]{};
+
+public:
+    StructureText() = default;
+
+    StructureText(const WindowKinds &kinds, std::string_view title) {
+        render(kinds, title);
+    }
+
+    void render(const WindowKinds &kinds, std::string_view title) {
+        m_text.clear();
+        m_text.reserve(structureSize(kinds, title));
+        auto append = [this](BuildStep step, std::initializer_list<std::string_view> parts) {
+            for (std::string_view part: parts) {
+                m_text.append(part);
+            }
+            m_segmentEnds[static_cast<std::size_t>(step)] = static_cast<std::uint32_t>(m_text.size());
+        };
+        append(BuildStep::NativeWindow, {fragment(kinds.nativeWindow)});
+        append(BuildStep::Menubar, {fragment(kinds.menubar)});
+        append(BuildStep::Title, {titlePrefix, title, titleSuffix});
+        append(BuildStep::DefaultBackgroundColor, {fragment(kinds.defaultBackgroundColor)});
+    }
+
+    std::string_view segment(BuildStep step) const {
+        auto index = static_cast<std::size_t>(step);
+        std::uint32_t begin = index == 0 ? 0 : m_segmentEnds[index - 1];
+        return std::string_view(m_text).substr(begin, m_segmentEnds[index] - begin);
+    }
+
+    // False for a default-constructed text, which has no segments yet.
+    bool rendered() const {
+        return m_segmentEnds[segments - 1] != 0;
+    }
+
+    std::string_view title() const {
+        if (!rendered()) {
+            return {};
+        }
+        std::string_view segment = this->segment(BuildStep::Title);
+        return segment.substr(titlePrefix.size(), segment.size() - titlePrefix.size() - titleSuffix.size());
+    }
+
+    // Only the title and the segments after it move. A text not rendered yet is rendered with the title alone.
+    void replaceTitle(std::string_view title) {
+        if (!rendered()) {
+            render(WindowKinds{}, title);
+            return;
+        }
+        auto index = static_cast<std::size_t>(BuildStep::Title);
+        std::size_t begin = m_segmentEnds[index - 1] + titlePrefix.size();
+        std::size_t oldSize = m_segmentEnds[index] - titleSuffix.size() - begin;
+        m_text.replace(begin, oldSize, title);
+        for (std::size_t i = index; i < segments; ++i) {
+            m_segmentEnds[i] = static_cast<std::uint32_t>(m_segmentEnds[i] - oldSize + title.size());
+        }
+    }
+
+    std::string_view view() const {
+        return m_text;
+    }
+};
+
+class MacOSWindow {
+public:
+    WindowKinds kinds;
+    WindowTitle title;
+
+    std::string_view getTitle() const {
+        return title;
+    }
+
+    std::string structure() const {
+        return renderStructure(kinds, title);
+    }
+
+    void printStructure() {
+        writeStructure(outputSink(), kinds, title);
+    }
+};
+
+class WindowsWindow {
+public:
+    WindowKinds kinds;
+    WindowTitle title;
+
+    std::string_view getTitle() const {
+        return title;
+    }
+
+    std::string structure() const {
+        return renderStructure(kinds, title);
+    }
+
+    void printStructure() {
+        writeStructure(outputSink(), kinds, title);
+    }
+};
+
+// Columnar store of built windows: one dense array per part, all titles in one buffer.
+class WindowTable {
+    std::vector<NativeWindowKind> m_nativeWindows;
+    std::vector<MenubarKind> m_menubars;
+    std::vector<BackgroundColorKind> m_backgroundColors;
+    std::vector<std::uint32_t> m_titleOffsets{0};
+    std::string m_titles;
+
+public:
+    std::size_t addRow() {
+        m_nativeWindows.push_back(NativeWindowKind::None);
+        m_menubars.push_back(MenubarKind::None);
+        m_backgroundColors.push_back(BackgroundColorKind::None);
+        m_titleOffsets.push_back(m_titleOffsets.back());
+        return size() - 1;
+    }
+
+    void removeLastRow() {
+        m_nativeWindows.pop_back();
+        m_menubars.pop_back();
+        m_backgroundColors.pop_back();
+        m_titleOffsets.pop_back();
+        m_titles.resize(m_titleOffsets.back());
+    }
+
+    // Room for rows more rows with titleChars more title bytes, on top of what the table holds.
+    void reserveAppend(std::size_t rows, std::size_t titleChars) {
+        ::reserveAppend(m_nativeWindows, rows);
+        ::reserveAppend(m_menubars, rows);
+        ::reserveAppend(m_backgroundColors, rows);
+        ::reserveAppend(m_titleOffsets, rows);
+        ::reserveAppend(m_titles, titleChars);
+    }
+
+    void clear() {
+        m_nativeWindows.clear();
+        m_menubars.clear();
+        m_backgroundColors.clear();
+        m_titleOffsets.resize(1);
+        m_titles.clear();
+    }
+
+    std::size_t size() const {
+        return m_nativeWindows.size();
+    }
+
+    void setNativeWindow(std::size_t row, NativeWindowKind kind) {
+        m_nativeWindows[row] = kind;
+    }
+
+    void setMenubar(std::size_t row, MenubarKind kind) {
+        m_menubars[row] = kind;
+    }
+
+    void setBackgroundColor(std::size_t row, BackgroundColorKind kind) {
+        m_backgroundColors[row] = kind;
+    }
+
+    // Titles are stored back to back, so only the last row can get its title.
+    void setTitle(std::size_t row, std::string_view title) {
+        assert(row + 1 == size());
+        m_titles.resize(m_titleOffsets[row]);
+        m_titles.append(title);
+        m_titleOffsets[row + 1] = static_cast<std::uint32_t>(m_titles.size());
+    }
+
+    std::span<const NativeWindowKind> nativeWindows() const {
+        return m_nativeWindows;
+    }
+
+    std::span<const MenubarKind> menubars() const {
+        return m_menubars;
+    }
+
+    std::span<const BackgroundColorKind> backgroundColors() const {
+        return m_backgroundColors;
+    }
+
+    std::string_view title(std::size_t row) const {
+        return std::string_view(m_titles).substr(m_titleOffsets[row], m_titleOffsets[row + 1] - m_titleOffsets[row]);
+    }
+
+    // Same text the platform windows render as their structure.
+    std::string structure(std::size_t row) const {
+        return renderStructure({m_nativeWindows[row], m_menubars[row], m_backgroundColors[row]}, title(row));
+    }
+};
+
+// Keeps one copy of every distinct title and hands out its index. The fragments of the other steps are
+// already shared: the kinds index the static fragment() literals. Not thread-safe.
+class TitleTable {
+    std::deque<std::string> m_storage;
+    std::vector<std::string_view> m_titles;
+    std::unordered_map<std::string_view, std::uint32_t> m_ids;
+
+public:
+    std::uint32_t intern(std::string_view title) {
+        auto found = m_ids.find(title);
+        if (found != m_ids.end()) {
+            return found->second;
+        }
+        auto id = static_cast<std::uint32_t>(m_titles.size());
+        std::string_view stored = m_storage.emplace_back(title);
+        m_titles.push_back(stored);
+        m_ids.emplace(stored, id);
+        return id;
+    }
+
+    std::string_view title(std::uint32_t id) const {
+        return m_titles[id];
+    }
+
+    std::size_t size() const {
+        return m_titles.size();
+    }
+
+    // Estimated heap bytes of the table.
+    std::size_t bytes() const {
+        std::size_t bytes = 0;
+        for (const std::string &title: m_storage) {
+            bytes += sizeof(std::string) + (title.capacity() > std::string().capacity() ? title.capacity() + 1 : 0);
+        }
+        return bytes + m_titles.capacity() * sizeof(std::string_view) +
+               m_ids.size() * (sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void *)) +
+               m_ids.bucket_count() * sizeof(void *);
+    }
+};
+
+// A window as fragment IDs: the kinds and the index of its title in a TitleTable. Equal windows built
+// against the same table have equal IDs, so comparing two is O(1).
+struct InternedWindow {
+    WindowKinds kinds;
+    std::uint32_t title = 0;
+
+    bool operator==(const InternedWindow &) const = default;
+
+    std::string structure(const TitleTable &titles) const {
+        return renderStructure(kinds, titles.title(title));
+    }
+
+    void printStructure(const TitleTable &titles) const {
+        writeStructure(outputSink(), kinds, titles.title(title));
+    }
+};
+
+// Batches write through spans set long before the call, so a short one must fail in Release builds too.
+inline void checkBatchOutput(std::size_t outputSize, std::size_t titleCount) {
+    if (outputSize < titleCount) {
+        throw std::out_of_range("window batch output holds fewer windows than titles");
+    }
+}
+
+template<typename Window>
+void buildWindowBatch(const WindowKinds &kinds, std::span<const std::string_view> titles, std::span<Window> windows) {
+    checkBatchOutput(windows.size(), titles.size());
+    for (std::size_t i = 0; i < titles.size(); ++i) {
+        windows[i].kinds = kinds;
+        windows[i].title.assign(titles[i]);
+    }
+}
+
+class WindowBuilder {
+public:
+    // Announces the steps that will follow, so the product can be reserved at once.
+    virtual void prepare(std::span<const BuildStep> steps, std::size_t titleSize) = 0;
+
+    virtual void createNativeWindow() = 0;
+
+    virtual void addMenubar() = 0;
+
+    virtual void setTitle(std::string_view title) = 0;
+
+    virtual void setDefaultBackgroundColor() = 0;
+
+    // Builds a whole window per title into the storage given to the concrete builder.
+    virtual void buildWindows(std::span<const std::string_view> titles) = 0;
+
+    // Keeps the window built so far as a prototype and starts the current window over. Steps announced by
+    // prepare() without BuildStep::Title describe such a prototype, so builders can record them instead.
+    virtual void saveTemplate() = 0;
+
+    // Makes the current window a copy of the saved prototype.
+    virtual void cloneTemplate() = 0;
+};
+
+class MacOSWindowBuilder final : public WindowBuilder {
+    WindowPtr<MacOSWindow> window;
+    WindowArena<MacOSWindow> *m_arena;
+    std::span<MacOSWindow> m_output;
+    bool m_recording = false;
+    WindowKinds m_recorded;
+    WindowKinds m_template;
+
+    // The window is only created once a step needs it.
+    MacOSWindow &current() {
+        if (!window) {
+            window = makeWindow(m_arena);
+        }
+        return *window;
+    }
+
+    // A template only records its parts, so preparing it creates no window.
+    WindowKinds &currentKinds() {
+        return m_recording ? m_recorded : current().kinds;
+    }
+
+public:
+    static constexpr WindowKinds kinds{
+            NativeWindowKind::StandardMacOS,
+            MenubarKind::MacOSDefault,
+            BackgroundColorKind::MacOSDefault
+    };
+
+    // With an arena the windows stay owned by it, so their handles are only valid until its releaseAll().
+    explicit MacOSWindowBuilder(WindowArena<MacOSWindow> *arena = nullptr) : m_arena(arena) {
+    }
+
+    // Drops the window under construction.
+    void reset() {
+        window.reset();
+        m_recording = false;
+    }
+
+    void prepare(std::span<const BuildStep> steps, std::size_t titleSize) override {
+        m_recording = describesTemplate(steps);
+        if (m_recording) {
+            m_recorded = {};
+        } else {
+            current().title.reserve(titleSize);
+        }
+    }
+
+    void createNativeWindow() override {
+        currentKinds().nativeWindow = kinds.nativeWindow;
+    }
+
+    void addMenubar() override {
+        currentKinds().menubar = kinds.menubar;
+    }
+
+    void setTitle(std::string_view title) override {
+        current().title.assign(title);
+    }
+
+    void setDefaultBackgroundColor() override {
+        currentKinds().defaultBackgroundColor = kinds.defaultBackgroundColor;
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        buildWindowBatch(kinds, titles, m_output);
+    }
+
+    void saveTemplate() override {
+        if (m_recording) {
+            m_template = m_recorded;
+            m_recording = false;
+        } else {
+            m_template = current().kinds;
+            window.reset();
+        }
+    }
+
+    void cloneTemplate() override {
+        MacOSWindow &clone = current();
+        clone.kinds = m_template;
+        clone.title.clear();
+    }
+
+    void setOutput(std::span<MacOSWindow> windows) {
+        m_output = windows;
+    }
+
+    std::span<MacOSWindow> output() const {
+        return m_output;
+    }
+
+    // Hands the built window over; the next step starts a new one.
+    WindowPtr<MacOSWindow> getWindow() {
+        return std::move(window);
+    }
+};
+
+class WindowsWindowBuilder final : public WindowBuilder {
+    WindowPtr<WindowsWindow> window;
+    WindowArena<WindowsWindow> *m_arena;
+    std::span<WindowsWindow> m_output;
+    bool m_recording = false;
+    WindowKinds m_recorded;
+    WindowKinds m_template;
+
+    // The window is only created once a step needs it.
+    WindowsWindow &current() {
+        if (!window) {
+            window = makeWindow(m_arena);
+        }
+        return *window;
+    }
+
+    // A template only records its parts, so preparing it creates no window.
+    WindowKinds &currentKinds() {
+        return m_recording ? m_recorded : current().kinds;
+    }
+
+public:
+    static constexpr WindowKinds kinds{
+            NativeWindowKind::StandardWindows,
+            MenubarKind::WindowsDefault,
+            BackgroundColorKind::WindowsDefault
+    };
+
+    // With an arena the windows stay owned by it, so their handles are only valid until its releaseAll().
+    explicit WindowsWindowBuilder(WindowArena<WindowsWindow> *arena = nullptr) : m_arena(arena) {
+    }
+
+    // Drops the window under construction.
+    void reset() {
+        window.reset();
+        m_recording = false;
+    }
+
+    void prepare(std::span<const BuildStep> steps, std::size_t titleSize) override {
+        m_recording = describesTemplate(steps);
+        if (m_recording) {
+            m_recorded = {};
+        } else {
+            current().title.reserve(titleSize);
+        }
+    }
+
+    void createNativeWindow() override {
+        currentKinds().nativeWindow = kinds.nativeWindow;
+    }
+
+    void addMenubar() override {
+        currentKinds().menubar = kinds.menubar;
+    }
+
+    void setTitle(std::string_view title) override {
+        current().title.assign(title);
+    }
+
+    void setDefaultBackgroundColor() override {
+        currentKinds().defaultBackgroundColor = kinds.defaultBackgroundColor;
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        buildWindowBatch(kinds, titles, m_output);
+    }
+
+    void saveTemplate() override {
+        if (m_recording) {
+            m_template = m_recorded;
+            m_recording = false;
+        } else {
+            m_template = current().kinds;
+            window.reset();
+        }
+    }
+
+    void cloneTemplate() override {
+        WindowsWindow &clone = current();
+        clone.kinds = m_template;
+        clone.title.clear();
+    }
+
+    void setOutput(std::span<WindowsWindow> windows) {
+        m_output = windows;
+    }
+
+    std::span<WindowsWindow> output() const {
+        return m_output;
+    }
+
+    // Hands the built window over; the next step starts a new one.
+    WindowPtr<WindowsWindow> getWindow() {
+        return std::move(window);
+    }
+};
+
+// Emits the windows of PlatformBuilder's platform as rows of a WindowTable instead of separate products.
+template<typename PlatformBuilder>
+class WindowTableBuilder final : public WindowBuilder {
+    static constexpr WindowKinds kinds = PlatformBuilder::kinds;
+
+    WindowTable *m_table;
+    std::size_t m_row = 0;
+    bool m_recording = false;
+    WindowKinds m_recorded;
+    WindowKinds m_template;
+
+public:
+    explicit WindowTableBuilder(WindowTable *table) : m_table(table) {
+    }
+
+    // Every window built by the manager starts a new row; a template is only recorded.
+    void prepare(std::span<const BuildStep> steps, std::size_t) override {
+        m_recording = describesTemplate(steps);
+        if (m_recording) {
+            m_recorded = {};
+        } else {
+            m_row = m_table->addRow();
+        }
+    }
+
+    void createNativeWindow() override {
+        if (m_recording) {
+            m_recorded.nativeWindow = kinds.nativeWindow;
+        } else {
+            m_table->setNativeWindow(m_row, kinds.nativeWindow);
+        }
+    }
+
+    void addMenubar() override {
+        if (m_recording) {
+            m_recorded.menubar = kinds.menubar;
+        } else {
+            m_table->setMenubar(m_row, kinds.menubar);
+        }
+    }
+
+    void setTitle(std::string_view title) override {
+        m_table->setTitle(m_row, title);
+    }
+
+    void setDefaultBackgroundColor() override {
+        if (m_recording) {
+            m_recorded.defaultBackgroundColor = kinds.defaultBackgroundColor;
+        } else {
+            m_table->setBackgroundColor(m_row, kinds.defaultBackgroundColor);
+        }
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        m_table->reserveAppend(titles.size(), titleChars(titles));
+        for (std::string_view title: titles) {
+            m_row = m_table->addRow();
+            m_table->setNativeWindow(m_row, kinds.nativeWindow);
+            m_table->setMenubar(m_row, kinds.menubar);
+            m_table->setTitle(m_row, title);
+            m_table->setBackgroundColor(m_row, kinds.defaultBackgroundColor);
+        }
+    }
+
+    void saveTemplate() override {
+        if (m_recording) {
+            m_template = m_recorded;
+            m_recording = false;
+        } else {
+            m_template = {m_table->nativeWindows()[m_row], m_table->menubars()[m_row],
+                          m_table->backgroundColors()[m_row]};
+            m_table->removeLastRow();
+        }
+    }
+
+    void cloneTemplate() override {
+        m_row = m_table->addRow();
+        m_table->setNativeWindow(m_row, m_template.nativeWindow);
+        m_table->setMenubar(m_row, m_template.menubar);
+        m_table->setBackgroundColor(m_row, m_template.defaultBackgroundColor);
+    }
+
+    std::size_t getRow() const {
+        return m_row;
+    }
+};
+
+// Writes each fragment to the sink as its step runs, so nothing but the sink buffer is held per window.
+// A window's line ends with its last announced step. Template windows only record their kinds; the clone
+// writes them around the title.
+template<typename PlatformBuilder>
+class StreamingWindowBuilder final : public WindowBuilder {
+    static constexpr WindowKinds kinds = PlatformBuilder::kinds;
+
+    OutputSink *m_sink;
+    std::size_t m_remainingSteps = 0;
+    bool m_recording = false;
+    WindowKinds m_recorded;
+    WindowKinds m_template;
+    BackgroundColorKind m_pendingBackgroundColor = BackgroundColorKind::None;
+
+    void write(std::string_view text) {
+        if (!m_recording) {
+            m_sink->write(text);
+        }
+    }
+
+    void stepDone() {
+        if (m_remainingSteps > 0 && --m_remainingSteps == 0 && !m_recording) {
+            m_sink->write("\n");
+        }
+    }
+
+public:
+    explicit StreamingWindowBuilder(OutputSink &sink) : m_sink(&sink) {
+    }
+
+    // Steps without a title describe a template, which is recorded for cloneTemplate() instead of written.
+    void prepare(std::span<const BuildStep> steps, std::size_t) override {
+        m_remainingSteps = steps.size();
+        m_recording = describesTemplate(steps);
+        m_recorded = {};
+        m_pendingBackgroundColor = BackgroundColorKind::None;
+    }
+
+    void createNativeWindow() override {
+        m_recorded.nativeWindow = kinds.nativeWindow;
+        write(fragment(kinds.nativeWindow));
+        stepDone();
+    }
+
+    void addMenubar() override {
+        m_recorded.menubar = kinds.menubar;
+        write(fragment(kinds.menubar));
+        stepDone();
+    }
+
+    void setTitle(std::string_view title) override {
+        write(titlePrefix);
+        write(title);
+        write(titleSuffix);
+        if (m_pendingBackgroundColor != BackgroundColorKind::None) {
+            write(fragment(std::exchange(m_pendingBackgroundColor, BackgroundColorKind::None)));
+        }
+        stepDone();
+    }
+
+    void setDefaultBackgroundColor() override {
+        m_recorded.defaultBackgroundColor = kinds.defaultBackgroundColor;
+        write(fragment(kinds.defaultBackgroundColor));
+        stepDone();
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        for (std::string_view title: titles) {
+            writeStructure(*m_sink, kinds, title);
+        }
+    }
+
+    void saveTemplate() override {
+        m_template = m_recorded;
+        m_recording = false;
+        m_remainingSteps = 0;
+    }
+
+    // The template parts that come before the title are written now, the background color after it.
+    void cloneTemplate() override {
+        m_sink->write(fragment(m_template.nativeWindow));
+        m_sink->write(fragment(m_template.menubar));
+        m_pendingBackgroundColor = m_template.defaultBackgroundColor;
+        m_remainingSteps = 1;
+    }
+};
+
+// Builds InternedWindows whose titles live once in a shared TitleTable.
+template<typename PlatformBuilder>
+class InterningWindowBuilder final : public WindowBuilder {
+    static constexpr WindowKinds kinds = PlatformBuilder::kinds;
+
+    TitleTable *m_titles;
+    InternedWindow m_window;
+    InternedWindow m_template;
+    std::span<InternedWindow> m_output;
+
+public:
+    explicit InterningWindowBuilder(TitleTable *titles) : m_titles(titles) {
+    }
+
+    void prepare(std::span<const BuildStep>, std::size_t) override {
+        m_window = {};
+    }
+
+    void createNativeWindow() override {
+        m_window.kinds.nativeWindow = kinds.nativeWindow;
+    }
+
+    void addMenubar() override {
+        m_window.kinds.menubar = kinds.menubar;
+    }
+
+    void setTitle(std::string_view title) override {
+        m_window.title = m_titles->intern(title);
+    }
+
+    void setDefaultBackgroundColor() override {
+        m_window.kinds.defaultBackgroundColor = kinds.defaultBackgroundColor;
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        checkBatchOutput(m_output.size(), titles.size());
+        for (std::size_t i = 0; i < titles.size(); ++i) {
+            m_output[i] = {kinds, m_titles->intern(titles[i])};
+        }
+    }
+
+    void saveTemplate() override {
+        m_template = m_window;
+        m_window = {};
+    }
+
+    void cloneTemplate() override {
+        m_window = m_template;
+    }
+
+    void setOutput(std::span<InternedWindow> windows) {
+        m_output = windows;
+    }
+
+    std::span<InternedWindow> output() const {
+        return m_output;
+    }
+
+    InternedWindow getWindow() {
+        return std::exchange(m_window, {});
+    }
+};
+
+class WindowCreationManager {
+    WindowBuilder *m_builder;
+
+public:
+    void setBuilder(WindowBuilder *builder) {
+        m_builder = builder;
+    }
+
+    void createDefaultWindow() {
+        INSTRUMENT_SCOPE("WindowCreationManager::createDefaultWindow");
+        INSTRUMENTED("WindowBuilder::prepare", m_builder->prepare(windowSteps, defaultWindowTitle.size()));
+        INSTRUMENTED("WindowBuilder::createNativeWindow", m_builder->createNativeWindow());
+        INSTRUMENTED("WindowBuilder::addMenubar", m_builder->addMenubar());
+        INSTRUMENTED("WindowBuilder::setTitle", m_builder->setTitle(defaultWindowTitle));
+        INSTRUMENTED("WindowBuilder::setDefaultBackgroundColor", m_builder->setDefaultBackgroundColor());
+    }
+
+    void createWindowWithTitle(std::string_view title) {
+        INSTRUMENT_SCOPE("WindowCreationManager::createWindowWithTitle");
+        INSTRUMENTED("WindowBuilder::prepare", m_builder->prepare(windowSteps, title.size()));
+        INSTRUMENTED("WindowBuilder::createNativeWindow", m_builder->createNativeWindow());
+        INSTRUMENTED("WindowBuilder::addMenubar", m_builder->addMenubar());
+        INSTRUMENTED("WindowBuilder::setTitle", m_builder->setTitle(title));
+        INSTRUMENTED("WindowBuilder::setDefaultBackgroundColor", m_builder->setDefaultBackgroundColor());
+    }
+
+    // Fills the storage set on the concrete builder with one window per title.
+    void createWindows(std::span<const std::string_view> titles) {
+        INSTRUMENTED("WindowBuilder::buildWindows", m_builder->buildWindows(titles));
+    }
+
+    // Builds the title-independent part once; createWindowFromTemplate() then only clones it and adds the title.
+    void prepareTemplateWindow() {
+        INSTRUMENT_SCOPE("WindowCreationManager::prepareTemplateWindow");
+        INSTRUMENTED("WindowBuilder::prepare", m_builder->prepare(templateSteps, 0));
+        INSTRUMENTED("WindowBuilder::createNativeWindow", m_builder->createNativeWindow());
+        INSTRUMENTED("WindowBuilder::addMenubar", m_builder->addMenubar());
+        INSTRUMENTED("WindowBuilder::setDefaultBackgroundColor", m_builder->setDefaultBackgroundColor());
+        INSTRUMENTED("WindowBuilder::saveTemplate", m_builder->saveTemplate());
+    }
+
+    void createWindowFromTemplate(std::string_view title) {
+        INSTRUMENT_SCOPE("WindowCreationManager::createWindowFromTemplate");
+        INSTRUMENTED("WindowBuilder::cloneTemplate", m_builder->cloneTemplate());
+        INSTRUMENTED("WindowBuilder::setTitle", m_builder->setTitle(title));
+    }
+
+    // Builds a window with its own Builder on the loop, giving the loop a turn after every step so the work
+    // posted to it (e.g. startup I/O callbacks) runs in between. Awaiting the task returns the window.
+    template<typename Builder>
+    static Task<decltype(std::declval<Builder &>().getWindow())> createWindowAsync(RunLoop &loop, std::string title) {
+        Builder builder;
+        builder.prepare(windowSteps, title.size());
+        co_await loop.schedule();
+        builder.createNativeWindow();
+        co_await loop.schedule();
+        builder.addMenubar();
+        co_await loop.schedule();
+        builder.setTitle(title);
+        co_await loop.schedule();
+        builder.setDefaultBackgroundColor();
+        co_return builder.getWindow();
+    }
+
+    // Changes the title of a built window without replaying its other steps.
+    template<typename Window>
+    static void updateTitle(Window &window, std::string_view newTitle) {
+        window.title.assign(newTitle);
+    }
+
+    // Patches the title segment of the rendered structure of a window, leaving the other segments in place.
+    static void updateTitle(StructureText &structure, std::string_view newTitle) {
+        structure.replaceTitle(newTitle);
+    }
+
+    // Builds one window per title with the given builder and pushes each finished window to the queue
+    // (e.g. a RingBuffer<WindowPtr<Window>, N>), waiting while it is full. Windows are pushed in title order;
+    // the consumer pops them on another thread.
+    template<typename Builder, typename Queue>
+    void createWindows(Builder &builder, std::span<const std::string_view> titles, Queue &queue) {
+        setBuilder(&builder);
+        for (std::string_view title: titles) {
+            createWindowWithTitle(title);
+            queue.push(builder.getWindow());
+        }
+    }
+};
+
+// Runs the steps on a known final builder, so every call is resolved at compile time and can be inlined.
+template<typename Builder>
+class StaticWindowCreationManager {
+    Builder *m_builder;
+
+public:
+    void setBuilder(Builder *builder) {
+        m_builder = builder;
+    }
+
+    void createDefaultWindow() {
+        createWindowWithTitle(defaultWindowTitle);
+    }
+
+    void createWindowWithTitle(std::string_view title) {
+        m_builder->prepare(windowSteps, title.size());
+        m_builder->createNativeWindow();
+        m_builder->addMenubar();
+        m_builder->setTitle(title);
+        m_builder->setDefaultBackgroundColor();
+    }
+};
+
+// Builds batches of windows on several threads, each thread with its own builder and manager.
+// Threads take chunks of the batch from a shared cursor until it is exhausted, so a slow thread
+// leaves its share to the others. windows[i] always receives the window for titles[i].
+// The worker threads are started once and wait between batches; the calling thread works as the first one.
+template<typename Builder, typename Window>
+class ParallelWindowCreationService {
+    struct Worker {
+        Builder builder;
+        WindowCreationManager manager;
+
+        Worker() {
+            manager.setBuilder(&builder);
+        }
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::size_t m_chunkSize;
+    // Serializes callers; the batch state below is guarded by m_batchMutex.
+    std::mutex m_mutex;
+    std::mutex m_batchMutex;
+    std::condition_variable m_batchReady;
+    std::condition_variable m_batchDone;
+    std::span<const std::string_view> m_titles;
+    std::span<Window> m_windows;
+    std::atomic<std::size_t> m_next = 0;
+    std::uint64_t m_batch = 0;
+    std::size_t m_running = 0;
+    bool m_stopping = false;
+    std::vector<std::jthread> m_threads;
+
+    void work(Worker &worker) {
+        for (;;) {
+            std::size_t begin = m_next.fetch_add(m_chunkSize, std::memory_order_relaxed);
+            if (begin >= m_titles.size()) {
+                return;
+            }
+            std::size_t count = std::min(m_chunkSize, m_titles.size() - begin);
+            worker.builder.setOutput(m_windows.subspan(begin, count));
+            worker.manager.createWindows(m_titles.subspan(begin, count));
+        }
+    }
+
+    void run(Worker &worker) {
+        std::uint64_t batch = 0;
+        std::unique_lock lock(m_batchMutex);
+        for (;;) {
+            m_batchReady.wait(lock, [&] {
+                return m_stopping || m_batch != batch;
+            });
+            if (m_stopping) {
+                return;
+            }
+            batch = m_batch;
+            lock.unlock();
+            work(worker);
+            lock.lock();
+            if (--m_running == 0) {
+                m_batchDone.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ParallelWindowCreationService(std::size_t threads = std::thread::hardware_concurrency(),
+                                           std::size_t chunkSize = 256) : m_chunkSize(chunkSize) {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 1; i < m_workers.size(); ++i) {
+            m_threads.emplace_back([this, &worker = *m_workers[i]] {
+                run(worker);
+            });
+        }
+    }
+
+    ParallelWindowCreationService(const ParallelWindowCreationService &) = delete;
+
+    ParallelWindowCreationService &operator=(const ParallelWindowCreationService &) = delete;
+
+    ~ParallelWindowCreationService() {
+        {
+            std::lock_guard lock(m_batchMutex);
+            m_stopping = true;
+        }
+        m_batchReady.notify_all();
+        m_threads.clear();
+    }
+
+    void createWindows(std::span<const std::string_view> titles, std::span<Window> windows) {
+        checkBatchOutput(windows.size(), titles.size());
+        std::lock_guard lock(m_mutex);
+        {
+            std::lock_guard batchLock(m_batchMutex);
+            m_titles = titles;
+            m_windows = windows;
+            m_next.store(0, std::memory_order_relaxed);
+            m_running = m_threads.size();
+            ++m_batch;
+        }
+        m_batchReady.notify_all();
+        work(*m_workers[0]);
+
+        std::unique_lock batchLock(m_batchMutex);
+        m_batchDone.wait(batchLock, [this] {
+            return m_running == 0;
+        });
+    }
+
+    std::size_t threads() const {
+        return m_workers.size();
+    }
+};
+
+// Shares the immutable windows built for repeated requests. Entries are keyed by the builder type and the
+// title, and the least recently used ones are evicted once their estimated size exceeds the memory cap.
+// Each entry is one make_shared node holding the window and its LRU links, indexed by an open-addressing
+// table of the owning pointers; a hit looks the title up as a string_view and allocates nothing, and a
+// miss reuses the node of the last eviction unless a caller still holds its window.
+// A miss builds the window straight into the node through the builder's batch output, then gives the
+// builder back the output it had. Not thread-safe.
+template<typename Window>
+class WindowCache {
+    struct Node {
+        Window window;
+        const void *builder = nullptr;
+        std::size_t hash = 0;
+        std::size_t bytes = 0;
+        Node *newer = nullptr;
+        Node *older = nullptr;
+    };
+
+    // Linear probing, at most half full; an empty pointer ends a probe sequence.
+    std::vector<std::shared_ptr<Node>> m_slots;
+    std::size_t m_size = 0;
+    // An evicted node nobody else shares, reused by the next miss instead of a new allocation.
+    std::shared_ptr<Node> m_spare;
+    Node *m_newest = nullptr;
+    Node *m_oldest = nullptr;
+    WindowCreationManager m_manager;
+    std::size_t m_memoryCap;
+    std::size_t m_bytes = 0;
+    std::uint64_t m_hits = 0;
+    std::uint64_t m_misses = 0;
+    std::uint64_t m_evictions = 0;
+
+    // One address per builder type, cheaper to hash and compare than a std::type_index.
+    template<typename Builder>
+    static const void *builderTag() {
+        static const char tag = 0;
+        return &tag;
+    }
+
+    static std::size_t hashOf(const void *builder, std::string_view title) {
+        return std::hash<const void *>()(builder) ^ (std::hash<std::string_view>()(title) * 31);
+    }
+
+    static std::size_t estimateBytes(std::string_view title) {
+        // The node with the control block of make_shared (a vtable pointer and two counts), the two table
+        // slots it takes at the maximum load and the heap copy of a title too long for the inline buffer.
+        std::size_t titleBytes = title.size() > WindowTitle::inlineCapacity ? title.size() + 1 : 0;
+        return sizeof(Node) + 2 * sizeof(void *) + 2 * sizeof(std::shared_ptr<Node>) + titleBytes;
+    }
+
+    std::size_t mask() const {
+        return m_slots.size() - 1;
+    }
+
+    // The slot holding the entry, or the empty slot where it would go.
+    std::size_t findSlot(std::size_t hash, const void *builder, std::string_view title) const {
+        std::size_t slot = hash & mask();
+        while (m_slots[slot]) {
+            const Node &node = *m_slots[slot];
+            if (node.hash == hash && node.builder == builder && node.window.title.view() == title) {
+                break;
+            }
+            slot = (slot + 1) & mask();
+        }
+        return slot;
+    }
+
+    std::size_t slotOf(const Node *node) const {
+        std::size_t slot = node->hash & mask();
+        while (m_slots[slot].get() != node) {
+            slot = (slot + 1) & mask();
+        }
+        return slot;
+    }
+
+    void grow() {
+        std::vector<std::shared_ptr<Node>> slots(std::max<std::size_t>(16, 2 * m_slots.size()));
+        m_slots.swap(slots);
+        for (std::shared_ptr<Node> &node: slots) {
+            if (node) {
+                std::size_t slot = node->hash & mask();
+                while (m_slots[slot]) {
+                    slot = (slot + 1) & mask();
+                }
+                m_slots[slot] = std::move(node);
+            }
+        }
+    }
+
+    // Backward-shift deletion, so no tombstones lengthen the probes.
+    void eraseSlot(std::size_t hole) {
+        m_slots[hole].reset();
+        for (std::size_t next = (hole + 1) & mask(); m_slots[next]; next = (next + 1) & mask()) {
+            std::size_t home = m_slots[next]->hash & mask();
+            if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                m_slots[hole] = std::move(m_slots[next]);
+                hole = next;
+            }
+        }
+        --m_size;
+    }
+
+    void unlink(Node *node) {
+        (node->newer ? node->newer->older : m_newest) = node->older;
+        (node->older ? node->older->newer : m_oldest) = node->newer;
+        node->newer = node->older = nullptr;
+    }
+
+    void pushNewest(Node *node) {
+        node->older = m_newest;
+        (m_newest ? m_newest->newer : m_oldest) = node;
+        m_newest = node;
+    }
+
+    void evict() {
+        while (m_bytes > m_memoryCap && m_oldest) {
+            Node *oldest = m_oldest;
+            unlink(oldest);
+            m_bytes -= oldest->bytes;
+            std::size_t slot = slotOf(oldest);
+            std::shared_ptr<Node> owner = std::move(m_slots[slot]);
+            eraseSlot(slot);
+            if (owner.use_count() == 1) {
+                m_spare = std::move(owner);
+            }
+            ++m_evictions;
+        }
+    }
+
+public:
+    explicit WindowCache(std::size_t memoryCap) : m_memoryCap(memoryCap) {
+    }
+
+    template<typename Builder>
+    std::shared_ptr<const Window> createDefaultWindow(Builder &builder) {
+        return createWindowWithTitle(builder, defaultWindowTitle);
+    }
+
+    template<typename Builder>
+    std::shared_ptr<const Window> createWindowWithTitle(Builder &builder, std::string_view title) {
+        const void *tag = builderTag<Builder>();
+        std::size_t hash = hashOf(tag, title);
+        if (m_size > 0) {
+            std::size_t slot = findSlot(hash, tag, title);
+            if (const std::shared_ptr<Node> &found = m_slots[slot]) {
+                ++m_hits;
+                unlink(found.get());
+                pushNewest(found.get());
+                return std::shared_ptr<const Window>(found, &found->window);
+            }
+        }
+
+        ++m_misses;
+        std::shared_ptr<Node> node = m_spare ? std::move(m_spare) : std::make_shared<Node>();
+        std::span<Window> callerOutput = builder.output();
+        builder.setOutput(std::span<Window>(&node->window, 1));
+        m_manager.setBuilder(&builder);
+        m_manager.createWindows(std::span<const std::string_view>(&title, 1));
+        builder.setOutput(callerOutput);
+        node->builder = tag;
+        node->hash = hash;
+        node->bytes = estimateBytes(title);
+
+        if (2 * (m_size + 1) > m_slots.size()) {
+            grow();
+        }
+        m_slots[findSlot(hash, tag, title)] = node;
+        ++m_size;
+        pushNewest(node.get());
+        m_bytes += node->bytes;
+        evict();
+        return std::shared_ptr<const Window>(std::move(node), &node->window);
+    }
+
+    // Keeps the table storage for the next entries.
+    void clear() {
+        std::fill(m_slots.begin(), m_slots.end(), nullptr);
+        m_size = 0;
+        m_newest = m_oldest = nullptr;
+        m_bytes = 0;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    std::size_t bytes() const {
+        return m_bytes;
+    }
+
+    std::uint64_t hits() const {
+        return m_hits;
+    }
+
+    std::uint64_t misses() const {
+        return m_misses;
+    }
+
+    std::uint64_t evictions() const {
+        return m_evictions;
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+// Binary snapshots of built windows, for restoring a session without replaying the builder steps.
+// A snapshot is written by a SerializingWindowBuilder and read in place, e.g. from a MappedFile:
+//   SnapshotHeader
+//   SnapshotRecord[windowCount]
+//   title bytes, referenced by the records
+// Integers are in native byte order; a snapshot is meant to be read on the machine that wrote it.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "output_sink.h"
+#include "window_builder.h"
+
+struct SnapshotHeader {
+    char magic[4] = {'W', 'N', 'D', 'S'};
+    std::uint32_t version = 1;
+    std::uint32_t windowCount = 0;
+    std::uint32_t titleBytes = 0;
+};
+
+struct SnapshotRecord {
+    WindowKinds kinds;
+    std::uint8_t reserved = 0;
+    std::uint32_t titleOffset = 0;
+    std::uint32_t titleSize = 0;
+};
+
+static_assert(sizeof(SnapshotHeader) == 16 && sizeof(SnapshotRecord) == 12);
+
+// The windows serialized so far, kept in the snapshot layout until they are written out.
+class WindowSnapshotWriter {
+    std::vector<SnapshotRecord> m_records;
+    std::string m_titles;
+
+public:
+    SnapshotRecord &addRecord() {
+        SnapshotRecord &record = m_records.emplace_back();
+        record.titleOffset = static_cast<std::uint32_t>(m_titles.size());
+        return record;
+    }
+
+    void removeLastRecord() {
+        m_titles.resize(m_records.back().titleOffset);
+        m_records.pop_back();
+    }
+
+    SnapshotRecord &lastRecord() {
+        return m_records.back();
+    }
+
+    // Only for the last record, whose title is still at the end of the title bytes.
+    void setTitle(std::string_view title) {
+        SnapshotRecord &record = m_records.back();
+        m_titles.resize(record.titleOffset);
+        m_titles.append(title);
+        record.titleSize = static_cast<std::uint32_t>(title.size());
+    }
+
+    // Room for records more records with titleChars more title bytes, on top of what the writer holds.
+    void reserveAppend(std::size_t records, std::size_t titleChars) {
+        ::reserveAppend(m_records, records);
+        ::reserveAppend(m_titles, titleChars);
+    }
+
+    void clear() {
+        m_records.clear();
+        m_titles.clear();
+    }
+
+    std::size_t size() const {
+        return m_records.size();
+    }
+
+    void writeTo(std::ostream &stream) const {
+        SnapshotHeader header;
+        header.windowCount = static_cast<std::uint32_t>(m_records.size());
+        header.titleBytes = static_cast<std::uint32_t>(m_titles.size());
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char *>(m_records.data()),
+                     static_cast<std::streamsize>(m_records.size() * sizeof(SnapshotRecord)));
+        stream.write(m_titles.data(), static_cast<std::streamsize>(m_titles.size()));
+    }
+
+    bool save(const std::string &path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        writeTo(file);
+        return static_cast<bool>(file);
+    }
+};
+
+// Serializes the windows it builds instead of creating products; another representation of the same steps.
+template<typename PlatformBuilder>
+class SerializingWindowBuilder final : public WindowBuilder {
+    static constexpr WindowKinds kinds = PlatformBuilder::kinds;
+
+    WindowSnapshotWriter *m_writer;
+    WindowKinds m_template;
+
+public:
+    explicit SerializingWindowBuilder(WindowSnapshotWriter *writer) : m_writer(writer) {
+    }
+
+    // Every window built by the manager starts a new record.
+    void prepare(std::span<const BuildStep>, std::size_t) override {
+        m_writer->addRecord();
+    }
+
+    void createNativeWindow() override {
+        m_writer->lastRecord().kinds.nativeWindow = kinds.nativeWindow;
+    }
+
+    void addMenubar() override {
+        m_writer->lastRecord().kinds.menubar = kinds.menubar;
+    }
+
+    void setTitle(std::string_view title) override {
+        m_writer->setTitle(title);
+    }
+
+    void setDefaultBackgroundColor() override {
+        m_writer->lastRecord().kinds.defaultBackgroundColor = kinds.defaultBackgroundColor;
+    }
+
+    void buildWindows(std::span<const std::string_view> titles) override {
+        m_writer->reserveAppend(titles.size(), titleChars(titles));
+        for (std::string_view title: titles) {
+            m_writer->addRecord().kinds = kinds;
+            m_writer->setTitle(title);
+        }
+    }
+
+    void saveTemplate() override {
+        m_template = m_writer->lastRecord().kinds;
+        m_writer->removeLastRecord();
+    }
+
+    void cloneTemplate() override {
+        m_writer->addRecord().kinds = m_template;
+    }
+};
+
+// A read-only file mapped into memory (POSIX mmap).
+class MappedFile {
+    void *m_data = nullptr;
+    std::size_t m_size = 0;
+
+    MappedFile(void *data, std::size_t size) : m_data(data), m_size(size) {
+    }
+
+public:
+    // Nothing when the file cannot be opened, is empty or cannot be mapped.
+    static std::optional<MappedFile> open(const std::string &path) {
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            return std::nullopt;
+        }
+        struct stat status{};
+        void *data = MAP_FAILED;
+        if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+            data = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        }
+        ::close(descriptor);
+        if (data == MAP_FAILED) {
+            return std::nullopt;
+        }
+        return MappedFile(data, static_cast<std::size_t>(status.st_size));
+    }
+
+    MappedFile(MappedFile &&other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (m_data) {
+            ::munmap(m_data, m_size);
+        }
+    }
+
+    std::span<const std::byte> bytes() const {
+        return {static_cast<const std::byte *>(m_data), m_size};
+    }
+};
+
+// Reads the windows of a snapshot in place: the titles are views into the snapshot bytes, which must
+// outlive the view.
+class WindowSnapshot {
+    const std::byte *m_records = nullptr;
+    const char *m_titles = nullptr;
+    std::size_t m_size = 0;
+
+    static bool validKinds(const WindowKinds &kinds) {
+        return kinds.nativeWindow <= NativeWindowKind::StandardWindows &&
+               kinds.menubar <= MenubarKind::WindowsDefault &&
+               kinds.defaultBackgroundColor <= BackgroundColorKind::WindowsDefault;
+    }
+
+public:
+    // Nothing when the bytes are not a complete, consistent snapshot.
+    static std::optional<WindowSnapshot> view(std::span<const std::byte> bytes) {
+        SnapshotHeader header;
+        if (bytes.size() < sizeof(header)) {
+            return std::nullopt;
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, SnapshotHeader().magic, sizeof(header.magic)) != 0 ||
+            header.version != SnapshotHeader().version ||
+            (bytes.size() - sizeof(header)) / sizeof(SnapshotRecord) < header.windowCount ||
+            bytes.size() - sizeof(header) - header.windowCount * sizeof(SnapshotRecord) != header.titleBytes) {
+            return std::nullopt;
+        }
+
+        WindowSnapshot snapshot;
+        snapshot.m_records = bytes.data() + sizeof(header);
+        snapshot.m_titles = reinterpret_cast<const char *>(snapshot.m_records +
+                                                           header.windowCount * sizeof(SnapshotRecord));
+        snapshot.m_size = header.windowCount;
+        for (std::size_t i = 0; i < snapshot.m_size; ++i) {
+            SnapshotRecord record = snapshot.record(i);
+            if (!validKinds(record.kinds) || record.titleOffset > header.titleBytes ||
+                record.titleSize > header.titleBytes - record.titleOffset) {
+                return std::nullopt;
+            }
+        }
+        return snapshot;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    SnapshotRecord record(std::size_t index) const {
+        SnapshotRecord record;
+        std::memcpy(&record, m_records + index * sizeof(SnapshotRecord), sizeof(record));
+        return record;
+    }
+
+    WindowKinds kinds(std::size_t index) const {
+        return record(index).kinds;
+    }
+
+    std::string_view title(std::size_t index) const {
+        SnapshotRecord entry = record(index);
+        return {m_titles + entry.titleOffset, entry.titleSize};
+    }
+
+    std::string structure(std::size_t index) const {
+        SnapshotRecord entry = record(index);
+        return renderStructure(entry.kinds, {m_titles + entry.titleOffset, entry.titleSize});
+    }
+
+    void printStructure(std::size_t index) const {
+        SnapshotRecord entry = record(index);
+        writeStructure(outputSink(), entry.kinds, {m_titles + entry.titleOffset, entry.titleSize});
+    }
+
+    // Makes a product of the window, copying only its title.
+    template<typename Window>
+    void restore(std::size_t index, Window &window) const {
+        SnapshotRecord entry = record(index);
+        window.kinds = entry.kinds;
+        window.title.assign(std::string_view(m_titles + entry.titleOffset, entry.titleSize));
+    }
+};
@@ -0,0 +1,92 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local std::uint64_t allocations = 0;
+    thread_local std::uint64_t allocatedBytes = 0;
+
+    void *allocate(std::size_t size) {
+        ++allocations;
+        allocatedBytes += size;
+        return std::malloc(size ? size : 1);
+    }
+
+    void *allocate(std::size_t size, std::align_val_t alignment) {
+        ++allocations;
+        allocatedBytes += size;
+        auto align = static_cast<std::size_t>(alignment);
+        return std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+}
+
+std::uint64_t threadAllocations() {
+    return allocations;
+}
+
+std::uint64_t threadAllocatedBytes() {
+    return allocatedBytes;
+}
+
+void *operator new(std::size_t size) {
+    if (void *pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *pointer = allocate(size, alignment)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
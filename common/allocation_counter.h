@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Totals of global operator new calls made by the calling thread. They only move in binaries that link
+// allocation_counter.cpp, which replaces the global allocation functions.
+std::uint64_t threadAllocations();
+
+std::uint64_t threadAllocatedBytes();
+
+// Allocations made by the calling thread since construction.
+class AllocationCounter {
+    std::uint64_t m_allocations = threadAllocations();
+    std::uint64_t m_bytes = threadAllocatedBytes();
+
+public:
+    std::uint64_t allocations() const {
+        return threadAllocations() - m_allocations;
+    }
+
+    std::uint64_t bytes() const {
+        return threadAllocatedBytes() - m_bytes;
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "output_sink.h"
+
+// Drops everything, for measuring the callers of a sink without the cost of the output.
+class DiscardOutputSink final : public OutputSink {
+    std::size_t m_bytes = 0;
+
+public:
+    void write(std::string_view text) override {
+        m_bytes += text.size();
+    }
+
+    void flush() override {
+    }
+
+    std::size_t bytes() const {
+        return m_bytes;
+    }
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::size_t iterations;
+    double nanosecondsPerIteration;
+    // std::clock() time of the whole process, so the worker threads a benchmark starts are included.
+    double cpuNanosecondsPerIteration;
+    double allocationsPerIteration;
+    double bytesPerIteration;
+};
+
+// Collects the results of benchmark() calls, prints them as they come and, when asked to on the command line,
+// writes them as Google Benchmark style JSON:
+//   --benchmark_format=json   JSON to stdout instead of the console lines
+//   --benchmark_out=<file>    JSON to a file, next to the console lines
+//   --allocation_checks_only  only the expect_allocations() checks, no timings
+class BenchmarkReporter {
+    std::vector<BenchmarkResult> m_results;
+    std::string m_executable;
+    std::string m_outputFile;
+    bool m_jsonToStdout = false;
+    bool m_allocationChecksOnly = false;
+    std::size_t m_allocationFailures = 0;
+    std::size_t m_resultFailures = 0;
+
+    static void writeString(std::ostream &stream, std::string_view text) {
+        stream << '"';
+        for (char c: text) {
+            if (c == '"' || c == '\\') {
+                stream << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                stream << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 0xf];
+            } else {
+                stream << c;
+            }
+        }
+        stream << '"';
+    }
+
+    void writeJson(std::ostream &stream) const {
+        stream << "{\n  \"context\": {\n    \"executable\": ";
+        writeString(stream, m_executable);
+        stream << ",\n    \"num_cpus\": " << std::thread::hardware_concurrency()
+#ifdef NDEBUG
+               << ",\n    \"library_build_type\": \"release\"\n  },\n";
+#else
+               << ",\n    \"library_build_type\": \"debug\"\n  },\n";
+#endif
+        stream << "  \"benchmarks\": [";
+        for (std::size_t i = 0; i < m_results.size(); ++i) {
+            const BenchmarkResult &result = m_results[i];
+            stream << (i ? ",\n" : "\n") << "    {\"name\": ";
+            writeString(stream, result.name);
+            stream << ", \"run_type\": \"iteration\", \"iterations\": " << result.iterations
+                   << ", \"real_time\": " << result.nanosecondsPerIteration
+                   << ", \"cpu_time\": " << result.cpuNanosecondsPerIteration << ", \"time_unit\": \"ns\""
+                   << ", \"allocations_per_iteration\": " << result.allocationsPerIteration
+                   << ", \"bytes_per_iteration\": " << result.bytesPerIteration << "}";
+        }
+        stream << "\n  ]\n}\n";
+    }
+
+public:
+    static BenchmarkReporter &instance() {
+        static BenchmarkReporter reporter;
+        return reporter;
+    }
+
+    void configure(int argc, char *argv[]) {
+        m_executable = argc > 0 ? argv[0] : "";
+        for (int i = 1; i < argc; ++i) {
+            std::string_view argument = argv[i];
+            if (argument == "--benchmark_format=json") {
+                m_jsonToStdout = true;
+            } else if (argument.starts_with("--benchmark_out=")) {
+                m_outputFile = argument.substr(std::string_view("--benchmark_out=").size());
+            } else if (argument == "--allocation_checks_only") {
+                m_allocationChecksOnly = true;
+            }
+        }
+    }
+
+    void add(BenchmarkResult result) {
+        if (!m_jsonToStdout) {
+            std::cout << result.name << ": " << result.nanosecondsPerIteration << " ns/op, "
+                      << result.allocationsPerIteration << " allocations/op" << std::endl;
+        }
+        m_results.push_back(std::move(result));
+    }
+
+    void checkAllocations(std::string_view name, std::uint64_t allocations, std::uint64_t budget) {
+        if (allocations > budget) {
+            ++m_allocationFailures;
+            std::cerr << "allocation budget exceeded: " << name << ": " << allocations << " allocations, budget "
+                      << budget << std::endl;
+        } else {
+            note() << "allocations: " << name << ": " << allocations << " (budget " << budget << ")" << std::endl;
+        }
+    }
+
+    void checkResult(std::string_view name, bool correct) {
+        if (!correct) {
+            ++m_resultFailures;
+            std::cerr << "wrong result: " << name << std::endl;
+        }
+    }
+
+    bool allocationChecksOnly() const {
+        return m_allocationChecksOnly;
+    }
+
+    // Extra lines for the console; kept out of the JSON.
+    std::ostream &note() {
+        static std::ostringstream discarded;
+        discarded.str({});
+        return m_jsonToStdout ? discarded : std::cout;
+    }
+
+    // The exit status of the run: 1 when an allocation budget was exceeded or a result check failed.
+    int finish() const {
+        if (m_jsonToStdout) {
+            writeJson(std::cout);
+        }
+        if (!m_outputFile.empty()) {
+            std::ofstream file(m_outputFile);
+            writeJson(file);
+        }
+        return m_allocationFailures == 0 && m_resultFailures == 0 ? 0 : 1;
+    }
+};
+
+// Times `function`, which performs `operations` iterations, in wall and CPU time and counts the allocations of
+// the calling thread.
+template<typename Function>
+void benchmark(const std::string &name, std::size_t operations, Function function) {
+    AllocationCounter counter;
+    std::clock_t cpuStart = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    double cpuNanoseconds = static_cast<double>(std::clock() - cpuStart) * 1e9 / CLOCKS_PER_SEC;
+    double allocations = static_cast<double>(counter.allocations()) / operations;
+    double bytes = static_cast<double>(counter.bytes()) / operations;
+    BenchmarkReporter::instance().add({name, operations, elapsed.count() / operations, cpuNanoseconds / operations,
+                                       allocations, bytes});
+}
+
+// Runs the body once to warm up caches, pools and storage, then again counting its allocations against the budget.
+template<typename Function>
+void expect_allocations(std::string_view name, std::uint64_t budget, Function body) {
+    body();
+    AllocationCounter counter;
+    body();
+    std::uint64_t allocations = counter.allocations();
+    BenchmarkReporter::instance().checkAllocations(name, allocations, budget);
+}
+
+// Checks what a benchmark computed; unlike assert() it stays in the optimized builds the benchmarks run in.
+inline bool expect_result(std::string_view name, bool correct) {
+    BenchmarkReporter::instance().checkResult(name, correct);
+    return correct;
+}
+
+// Runs `print` once per sink kind with the sink installed, writing into a scratch file.
+template<typename Function>
+void benchmark_output(const std::string &name, std::size_t operations, Function print) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "somanypatterns_output_benchmark.txt";
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    auto run = [&](const char *sinkName, OutputSink &sink) {
+        setOutputSink(&sink);
+        benchmark(name + ", " + sinkName, operations, [&] {
+            print();
+            sink.flush();
+        });
+        setOutputSink(nullptr);
+    };
+
+    {
+        StreamOutputSink sink(file);
+        run("flush per line", sink);
+    }
+    {
+        BufferedOutputSink sink(file);
+        run("buffered", sink);
+    }
+    {
+        AsyncOutputSink sink(file);
+        run("async", sink);
+    }
+
+    file.close();
+    std::filesystem::remove(path);
+}
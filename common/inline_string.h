@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Sizes of the texts assigned to the InlineStrings of one capacity, recorded when INLINE_STRING_STATS is defined.
+struct InlineStringStats {
+    static constexpr std::size_t buckets = 12;
+
+    std::uint64_t assignments = 0;
+    std::uint64_t overflows = 0;
+    // Bucket i counts sizes in [2^(i-1), 2^i), bucket 0 the empty texts, the last one everything longer.
+    std::uint64_t sizes[buckets]{};
+
+    void record(std::size_t size, bool overflow) {
+        ++assignments;
+        overflows += overflow;
+        ++sizes[std::min<std::size_t>(std::bit_width(size), buckets - 1)];
+    }
+
+    void merge(const InlineStringStats &other) {
+        assignments += other.assignments;
+        overflows += other.overflows;
+        for (std::size_t i = 0; i < buckets; ++i) {
+            sizes[i] += other.sizes[i];
+        }
+    }
+
+    void report(std::ostream &stream, std::size_t capacity) const {
+        stream << "InlineString<" << capacity << ">: " << assignments << " assignments, "
+               << overflows << " on the heap; sizes:";
+        for (std::size_t i = 0; i < buckets; ++i) {
+            if (std::uint64_t count = sizes[i]) {
+                stream << ' ' << (i == 0 ? 0 : std::size_t(1) << (i - 1)) << (i + 1 == buckets ? "+" : "") << ": "
+                       << count;
+            }
+        }
+        stream << '\n';
+    }
+};
+
+// Every thread records into its own InlineStringStats, so assignments on different threads share no cache line.
+// A thread's counts join the totals when it exits, and the calling thread's ones when the totals are read.
+template<std::size_t Capacity>
+class InlineStringStatsRegistry {
+    struct Totals {
+        std::mutex mutex;
+        InlineStringStats stats;
+    };
+
+    struct ThreadStats {
+        InlineStringStats stats;
+
+        ~ThreadStats() {
+            flush();
+        }
+
+        void flush() {
+            Totals &shared = totals();
+            std::lock_guard lock(shared.mutex);
+            shared.stats.merge(stats);
+            stats = {};
+        }
+    };
+
+    static Totals &totals() {
+        static Totals instance;
+        return instance;
+    }
+
+    static ThreadStats &threadStats() {
+        // Constructs the totals first, so they outlive the per-thread stats flushing into them.
+        totals();
+        thread_local ThreadStats instance;
+        return instance;
+    }
+
+public:
+    static void record(std::size_t size, bool overflow) {
+        threadStats().stats.record(size, overflow);
+    }
+
+    static InlineStringStats snapshot() {
+        threadStats().flush();
+        Totals &shared = totals();
+        std::lock_guard lock(shared.mutex);
+        return shared.stats;
+    }
+};
+
+// String that keeps up to Capacity characters inside the object and moves to the heap only beyond that.
+// Once on the heap it stays there, short texts included, so the storage is reused by the next long text.
+template<std::size_t Capacity>
+class InlineString {
+    std::size_t m_size = 0;
+    bool m_onHeap = false;
+    // m_heap is the active member while m_onHeap.
+    union {
+        char m_inline[Capacity]{};
+        std::string m_heap;
+    };
+
+    void record() {
+#ifdef INLINE_STRING_STATS
+        InlineStringStatsRegistry<Capacity>::record(m_size, m_size > Capacity);
+#endif
+    }
+
+    template<typename Text>
+    void moveToHeap(Text &&text) {
+        std::construct_at(&m_heap, std::forward<Text>(text));
+        m_onHeap = true;
+    }
+
+    // Takes over the heap text of other, which is left empty.
+    void steal(InlineString &other) {
+        if (m_onHeap) {
+            m_heap = std::move(other.m_heap);
+        } else {
+            moveToHeap(std::move(other.m_heap));
+        }
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+
+public:
+    static constexpr std::size_t inlineCapacity = Capacity;
+
+    InlineString() {
+    }
+
+    InlineString(std::string_view text) {
+        assign(text);
+    }
+
+    // Copies only the text, never the heap storage of a longer one held before.
+    InlineString(const InlineString &other) {
+        assign(other.view());
+    }
+
+    InlineString(InlineString &&other) noexcept {
+        if (other.m_size > Capacity) {
+            steal(other);
+        } else {
+            assign(other.view());
+        }
+    }
+
+    InlineString &operator=(const InlineString &other) {
+        if (this != &other) {
+            assign(other.view());
+        }
+        return *this;
+    }
+
+    InlineString &operator=(InlineString &&other) noexcept {
+        if (this != &other) {
+            if (other.m_size > Capacity) {
+                steal(other);
+            } else {
+                assign(other.view());
+            }
+        }
+        return *this;
+    }
+
+    ~InlineString() {
+        if (m_onHeap) {
+            std::destroy_at(&m_heap);
+        }
+    }
+
+    InlineString &operator=(std::string_view text) {
+        return assign(text);
+    }
+
+    // Only rvalue std::strings are adopted, by this and assign(); everything else, string literals included,
+    // takes the string_view overloads.
+    template<typename String>
+    requires std::same_as<String, std::string>
+    InlineString &operator=(String &&text) {
+        return assign(std::move(text));
+    }
+
+    InlineString &assign(std::string_view text) {
+        m_size = text.size();
+        if (m_onHeap) {
+            m_heap.assign(text);
+        } else if (m_size <= Capacity) {
+            std::copy(text.begin(), text.end(), m_inline);
+        } else {
+            moveToHeap(text);
+        }
+        record();
+        return *this;
+    }
+
+    template<typename String>
+    requires std::same_as<String, std::string>
+    InlineString &assign(String &&text) {
+        m_size = text.size();
+        if (m_onHeap) {
+            m_heap = std::move(text);
+        } else if (m_size <= Capacity) {
+            std::copy(text.begin(), text.end(), m_inline);
+        } else {
+            moveToHeap(std::move(text));
+        }
+        record();
+        return *this;
+    }
+
+    void reserve(std::size_t size) {
+        if (size <= Capacity) {
+            return;
+        }
+        if (!m_onHeap) {
+            std::string heap(view());
+            moveToHeap(std::move(heap));
+        }
+        m_heap.reserve(size);
+    }
+
+    // Keeps the heap storage, if any, for the next long text.
+    void clear() {
+        m_size = 0;
+    }
+
+    const char *data() const {
+        return m_onHeap ? m_heap.data() : m_inline;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    // True once the string owns heap storage, whatever the size of its current text.
+    bool onHeap() const {
+        return m_onHeap;
+    }
+
+    std::string_view view() const {
+        return {data(), m_size};
+    }
+
+    operator std::string_view() const {
+        return view();
+    }
+
+    friend bool operator==(const InlineString &left, const InlineString &right) {
+        return left.view() == right.view();
+    }
+
+    // Counts of all threads that have exited or are calling this.
+    static InlineStringStats stats() {
+        return InlineStringStatsRegistry<Capacity>::snapshot();
+    }
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+// Opt-in probes for the construction hot paths. Without PATTERN_INSTRUMENTATION the macros expand to
+// nothing (INSTRUMENTED to its bare expression), so disabled builds pay nothing.
+//
+//   INSTRUMENT_SCOPE("name");              measures the rest of the enclosing scope
+//   INSTRUMENTED("name", expression);      measures one expression statement (commas allowed)
+//
+// Enabled builds must link allocation_counter.cpp. Instrumentation::report() prints the probes and runs
+// at exit as well.
+
+#ifdef PATTERN_INSTRUMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "allocation_counter.h"
+
+// Counts of latencies in power-of-two nanosecond buckets.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t buckets = 48;
+
+private:
+    std::atomic<std::uint64_t> m_counts[buckets]{};
+
+public:
+    void record(std::uint64_t nanoseconds) {
+        std::size_t bucket = std::min<std::size_t>(std::bit_width(nanoseconds), buckets - 1);
+        m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the given fraction (0..1] of the samples.
+    std::uint64_t percentile(double fraction) const {
+        std::uint64_t total = 0;
+        for (const auto &count: m_counts) {
+            total += count.load(std::memory_order_relaxed);
+        }
+        auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets; ++i) {
+            seen += m_counts[i].load(std::memory_order_relaxed);
+            if (seen >= target && seen > 0) {
+                return (std::uint64_t(1) << i) - 1;
+            }
+        }
+        return 0;
+    }
+};
+
+struct Probe {
+    std::string_view name;
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> allocatedBytes{0};
+    LatencyHistogram latency;
+
+};
+
+class Instrumentation {
+    // Allocated up front, so registering a probe inside a measured scope does not show up in its counts.
+    static constexpr std::size_t maxProbes = 128;
+
+    std::mutex m_mutex;
+    std::unique_ptr<Probe[]> m_probes = std::make_unique<Probe[]>(maxProbes);
+    std::size_t m_size = 0;
+
+    Instrumentation() = default;
+
+public:
+    static Instrumentation &instance() {
+        static Instrumentation instrumentation;
+        // Registered after construction so the report runs before the destructor.
+        [[maybe_unused]] static bool reportAtExit = std::atexit([] {
+            instance().report(std::cerr);
+        }) == 0;
+        return instrumentation;
+    }
+
+    // One probe per name, shared by every call site using it. Past maxProbes names share the last probe.
+    Probe &probe(std::string_view name) {
+        std::lock_guard lock(m_mutex);
+        for (std::size_t i = 0; i < m_size; ++i) {
+            if (m_probes[i].name == name) {
+                return m_probes[i];
+            }
+        }
+        if (m_size == maxProbes) {
+            m_probes[maxProbes - 1].name = "other probes";
+            return m_probes[maxProbes - 1];
+        }
+        m_probes[m_size].name = name;
+        return m_probes[m_size++];
+    }
+
+    // Stable for the lifetime of the program; the counters keep moving while probes run.
+    std::vector<const Probe *> probes() {
+        std::lock_guard lock(m_mutex);
+        std::vector<const Probe *> result;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            result.push_back(&m_probes[i]);
+        }
+        return result;
+    }
+
+    void report(std::ostream &stream) {
+        stream << "instrumentation:\n";
+        for (const Probe *probe: probes()) {
+            std::uint64_t calls = probe->calls.load();
+            if (calls == 0) {
+                continue;
+            }
+            stream << "  " << probe->name << ": " << calls << " calls, "
+                   << probe->nanoseconds.load() / calls << " ns mean, p50 <= " << probe->latency.percentile(0.5)
+                   << " ns, p99 <= " << probe->latency.percentile(0.99) << " ns, "
+                   << static_cast<double>(probe->allocations.load()) / calls << " allocations and "
+                   << static_cast<double>(probe->allocatedBytes.load()) / calls << " bytes per call\n";
+        }
+        stream.flush();
+    }
+};
+
+class ScopedProbe {
+    Probe &m_probe;
+    AllocationCounter m_allocations;
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+
+public:
+    explicit ScopedProbe(Probe &probe) : m_probe(probe) {
+    }
+
+    ScopedProbe(const ScopedProbe &) = delete;
+
+    ScopedProbe &operator=(const ScopedProbe &) = delete;
+
+    ~ScopedProbe() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count();
+        m_probe.calls.fetch_add(1, std::memory_order_relaxed);
+        m_probe.nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        m_probe.allocations.fetch_add(m_allocations.allocations(), std::memory_order_relaxed);
+        m_probe.allocatedBytes.fetch_add(m_allocations.bytes(), std::memory_order_relaxed);
+        m_probe.latency.record(elapsed);
+    }
+};
+
+#define INSTRUMENT_CONCAT_(left, right) left##right
+#define INSTRUMENT_CONCAT(left, right) INSTRUMENT_CONCAT_(left, right)
+
+#define INSTRUMENT_SCOPE(name) \
+    static Probe &INSTRUMENT_CONCAT(instrumentProbe_, __LINE__) = Instrumentation::instance().probe(name); \
+    ScopedProbe INSTRUMENT_CONCAT(instrumentScope_, __LINE__)(INSTRUMENT_CONCAT(instrumentProbe_, __LINE__))
+
+#define INSTRUMENTED(name, ...) \
+    do { \
+        INSTRUMENT_SCOPE(name); \
+        __VA_ARGS__; \
+    } while (false)
+
+#else
+
+#define INSTRUMENT_SCOPE(name)
+#define INSTRUMENTED(name, ...) __VA_ARGS__
+
+#endif
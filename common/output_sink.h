@@ -0,0 +1,194 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Destination of the text the demos print. Nothing is guaranteed to reach the stream before flush().
+class OutputSink {
+public:
+    virtual void write(std::string_view text) = 0;
+
+    virtual void flush() = 0;
+
+    virtual ~OutputSink() = default;
+
+    template<typename... Parts>
+    void writeLine(const Parts &...parts) {
+        (write(std::string_view(parts)), ...);
+        write("\n");
+    }
+};
+
+// Writes straight to the stream and flushes every line, like `std::cout << ... << std::endl`.
+class StreamOutputSink final : public OutputSink {
+    std::ostream &m_stream;
+
+public:
+    explicit StreamOutputSink(std::ostream &stream) : m_stream(stream) {
+    }
+
+    void write(std::string_view text) override {
+        m_stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (text.ends_with('\n')) {
+            m_stream.flush();
+        }
+    }
+
+    void flush() override {
+        m_stream.flush();
+    }
+};
+
+// Appends to a string owned by the caller; flush() does nothing.
+class StringOutputSink final : public OutputSink {
+    std::string &m_text;
+
+public:
+    explicit StringOutputSink(std::string &text) : m_text(text) {
+    }
+
+    void write(std::string_view text) override {
+        m_text.append(text);
+    }
+
+    void flush() override {
+    }
+};
+
+// Collects text in memory and hands it to the stream in large chunks. Not thread-safe.
+class BufferedOutputSink final : public OutputSink {
+    std::ostream &m_stream;
+    std::size_t m_capacity;
+    std::string m_buffer;
+
+public:
+    explicit BufferedOutputSink(std::ostream &stream, std::size_t capacity = 64 * 1024)
+            : m_stream(stream), m_capacity(capacity) {
+        m_buffer.reserve(capacity);
+    }
+
+    BufferedOutputSink(const BufferedOutputSink &) = delete;
+
+    BufferedOutputSink &operator=(const BufferedOutputSink &) = delete;
+
+    ~BufferedOutputSink() override {
+        flush();
+    }
+
+    void write(std::string_view text) override {
+        if (m_buffer.size() + text.size() > m_capacity) {
+            m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_buffer.clear();
+        }
+        m_buffer.append(text);
+    }
+
+    void flush() override {
+        m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+        m_stream.flush();
+    }
+};
+
+// Buffers text from any number of threads and writes it to the stream on a background thread.
+class AsyncOutputSink final : public OutputSink {
+    std::ostream &m_stream;
+    std::size_t m_capacity;
+    std::string m_pending;
+    std::string m_writing;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_written;
+    std::uint64_t m_flushRequested = 0;
+    std::uint64_t m_flushCompleted = 0;
+    bool m_stopping = false;
+    std::thread m_writer;
+
+    void run() {
+        std::unique_lock lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [this] {
+                return m_stopping || m_pending.size() >= m_capacity || m_flushRequested != m_flushCompleted;
+            });
+            if (m_stopping && m_pending.empty() && m_flushRequested == m_flushCompleted) {
+                return;
+            }
+            std::uint64_t flushRequested = m_flushRequested;
+            m_writing.swap(m_pending);
+            lock.unlock();
+
+            m_stream.write(m_writing.data(), static_cast<std::streamsize>(m_writing.size()));
+            if (flushRequested != m_flushCompleted) {
+                m_stream.flush();
+            }
+            m_writing.clear();
+
+            lock.lock();
+            m_flushCompleted = flushRequested;
+            m_written.notify_all();
+        }
+    }
+
+public:
+    explicit AsyncOutputSink(std::ostream &stream, std::size_t capacity = 64 * 1024)
+            : m_stream(stream), m_capacity(capacity) {
+        m_pending.reserve(capacity);
+        m_writing.reserve(capacity);
+        m_writer = std::thread(&AsyncOutputSink::run, this);
+    }
+
+    AsyncOutputSink(const AsyncOutputSink &) = delete;
+
+    AsyncOutputSink &operator=(const AsyncOutputSink &) = delete;
+
+    ~AsyncOutputSink() override {
+        flush();
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_writer.join();
+    }
+
+    void write(std::string_view text) override {
+        std::lock_guard lock(m_mutex);
+        m_pending.append(text);
+        if (m_pending.size() >= m_capacity) {
+            m_wake.notify_one();
+        }
+    }
+
+    // Blocks until everything written before the call has reached the stream.
+    void flush() override {
+        std::unique_lock lock(m_mutex);
+        std::uint64_t ticket = ++m_flushRequested;
+        m_wake.notify_one();
+        m_written.wait(lock, [this, ticket] {
+            return m_flushCompleted >= ticket;
+        });
+    }
+};
+
+inline OutputSink *&currentOutputSink() {
+    static OutputSink *sink = nullptr;
+    return sink;
+}
+
+// The sink used by the demo classes: buffered std::cout unless another one is set.
+inline OutputSink &outputSink() {
+    static BufferedOutputSink defaultSink(std::cout);
+    OutputSink *sink = currentOutputSink();
+    return sink ? *sink : defaultSink;
+}
+
+inline void setOutputSink(OutputSink *sink) {
+    currentOutputSink() = sink;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free queue for any number of producers and one consumer (so also for one producer).
+// Every slot carries a sequence number telling whose turn it is: producers claim a slot with one CAS on
+// the tail and publish it by bumping its sequence, the consumer takes published slots in order.
+// A full queue makes tryPush() fail and push() wait, which is the backpressure on the producers.
+template<typename T, std::size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>);
+
+    static constexpr std::size_t cacheLine = 64;
+
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    Slot m_slots[Capacity];
+    alignas(cacheLine) std::atomic<std::size_t> m_tail = 0;
+    alignas(cacheLine) std::atomic<std::size_t> m_head = 0;
+
+public:
+    RingBuffer() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    // Any thread. Leaves the value untouched and returns false when the queue is full.
+    bool tryPush(T &value) {
+        std::size_t position = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = m_slots[position % Capacity];
+            std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Any thread. Waits while the queue is full.
+    void push(T value) {
+        while (!tryPush(value)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // The consumer thread only. Moves up to output.size() values out and returns how many.
+    std::size_t tryPopBatch(std::span<T> output) {
+        std::size_t position = m_head.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        for (; count < output.size(); ++count, ++position) {
+            Slot &slot = m_slots[position % Capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+            output[count] = std::move(slot.value);
+            slot.sequence.store(position + Capacity, std::memory_order_release);
+        }
+        m_head.store(position, std::memory_order_relaxed);
+        return count;
+    }
+
+    // The consumer thread only. Waits for at least one value.
+    std::size_t popBatch(std::span<T> output) {
+        std::size_t count;
+        while ((count = tryPopBatch(output)) == 0 && !output.empty()) {
+            std::this_thread::yield();
+        }
+        return count;
+    }
+
+    // Exact only while no thread pushes or pops.
+    std::size_t size() const {
+        return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// Lazily started coroutine producing one T. A Task runs when it is awaited, or when RunLoop::run() is given it,
+// and resumes its awaiter when it completes.
+template<typename T>
+class Task {
+    static_assert(!std::is_void_v<T> && !std::is_reference_v<T>, "Task needs a value type");
+
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct ResumeContinuation {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    return handle.promise().continuation;
+                }
+
+                void await_resume() noexcept {
+                }
+            };
+            return ResumeContinuation{};
+        }
+
+        template<typename Value>
+        void return_value(Value &&result) {
+            value.emplace(std::forward<Value>(result));
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {
+    }
+
+    friend class RunLoop;
+
+public:
+    Task(Task &&other) noexcept: m_handle(std::exchange(other.m_handle, {})) {
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool done() const {
+        return m_handle.done();
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        m_handle.promise().continuation = continuation;
+        return m_handle;
+    }
+
+    T await_resume() {
+        promise_type &promise = m_handle.promise();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return std::move(*promise.value);
+    }
+};
+
+// Single-threaded executor, like the event loop of a UI thread. Coroutines co_await schedule() to give
+// the turn to the work queued before them, so construction steps interleave with posted callbacks.
+class RunLoop {
+    std::deque<std::function<void()>> m_queue;
+
+public:
+    auto schedule() {
+        struct Awaiter {
+            RunLoop &loop;
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                loop.m_queue.emplace_back([handle] {
+                    handle.resume();
+                });
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+        return Awaiter{*this};
+    }
+
+    void post(std::function<void()> work) {
+        m_queue.push_back(std::move(work));
+    }
+
+    // Runs the oldest queued work; false when there was none.
+    bool runOne() {
+        if (m_queue.empty()) {
+            return false;
+        }
+        std::function<void()> work = std::move(m_queue.front());
+        m_queue.pop_front();
+        work();
+        return true;
+    }
+
+    void runUntilIdle() {
+        while (runOne()) {
+        }
+    }
+
+    // Starts the task and runs the loop until the task completes, then returns its result.
+    template<typename T>
+    T run(Task<T> task) {
+        task.m_handle.resume();
+        while (!task.done() && runOne()) {
+        }
+        assert(task.done() && "the task waits for something that is not queued on this loop");
+        return task.await_resume();
+    }
+
+    std::size_t pending() const {
+        return m_queue.size();
+    }
+};
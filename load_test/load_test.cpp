@@ -0,0 +1,364 @@
+// Load generator for both demos. Every thread runs a random mix of window and control operations with its
+// own WindowCreationManager and builders and the shared WindowApplication factories. Each thread keeps the
+// last --live products of every kind alive, so every operation also destroys the product it replaces.
+//
+//   --threads=N                 worker threads (default: the hardware concurrency)
+//   --operations=N              operations per thread (default 1000000)
+//   --live=N                    products of each kind kept alive per thread (default 256)
+//   --macos_percent=N           share of the operations on MacOS products (default 50)
+//   --long_title_percent=N      share of titles longer than the inline title buffers (default 10)
+//   --window_weight=N           relative weight of window create/destroy operations (default 2)
+//   --button_weight=N           relative weight of button create/click/destroy operations (default 1)
+//   --text_edit_weight=N        relative weight of text edit create/setText/destroy operations (default 1)
+//   --seed=N                    seed of the per-thread random generators (default 1)
+//
+// Reports the throughput, the p50/p99/p999 latency and allocations of each operation and the peak RSS.
+// Latencies include one steady_clock::now() pair; the output of the demo classes is discarded.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "output_sink.h"
+#include "window_application.h"
+#include "window_builder.h"
+
+struct LoadOptions {
+    std::uint64_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::uint64_t operations = 1000000;
+    std::uint64_t live = 256;
+    std::uint64_t macosPercent = 50;
+    std::uint64_t longTitlePercent = 10;
+    std::uint64_t windowWeight = 2;
+    std::uint64_t buttonWeight = 1;
+    std::uint64_t textEditWeight = 1;
+    std::uint64_t seed = 1;
+};
+
+// False on an unknown option or a malformed value.
+bool parse_options(int argc, char *argv[], LoadOptions &options) {
+    struct Option {
+        std::string_view name;
+        std::uint64_t *value;
+    };
+    const Option known[] = {
+            {"--threads=", &options.threads},
+            {"--operations=", &options.operations},
+            {"--live=", &options.live},
+            {"--macos_percent=", &options.macosPercent},
+            {"--long_title_percent=", &options.longTitlePercent},
+            {"--window_weight=", &options.windowWeight},
+            {"--button_weight=", &options.buttonWeight},
+            {"--text_edit_weight=", &options.textEditWeight},
+            {"--seed=", &options.seed},
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        auto option = std::find_if(std::begin(known), std::end(known), [argument](const Option &candidate) {
+            return argument.starts_with(candidate.name);
+        });
+        if (option == std::end(known)) {
+            return false;
+        }
+        std::string_view value = argument.substr(option->name.size());
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), *option->value);
+        if (error != std::errc() || end != value.data() + value.size()) {
+            return false;
+        }
+    }
+    return options.threads > 0 && options.live > 0 && options.macosPercent <= 100 && options.longTitlePercent <= 100
+           && options.windowWeight + options.buttonWeight + options.textEditWeight > 0;
+}
+
+// Drops the text. Unlike DiscardOutputSink it keeps no count, so the workers can share it.
+class NullOutputSink final : public OutputSink {
+public:
+    void write(std::string_view) override {
+    }
+
+    void flush() override {
+    }
+};
+
+// Latency counts in buckets of 1/32 of a power of two, so a percentile is within about 3% of the exact one.
+class LatencyRecorder {
+    static constexpr unsigned subBucketBits = 5;
+    static constexpr std::uint64_t subBuckets = 1 << subBucketBits;
+    static constexpr std::size_t bucketCount = 40 * subBuckets;
+
+    std::vector<std::uint64_t> m_counts = std::vector<std::uint64_t>(bucketCount);
+    std::uint64_t m_total = 0;
+    std::uint64_t m_max = 0;
+
+    // Values below 2 * subBuckets have a bucket each; above, the top subBucketBits + 1 bits select it.
+    static std::size_t bucket(std::uint64_t nanoseconds) {
+        if (nanoseconds < 2 * subBuckets) {
+            return nanoseconds;
+        }
+        unsigned shift = std::bit_width(nanoseconds) - (subBucketBits + 1);
+        return std::min<std::size_t>(shift * subBuckets + (nanoseconds >> shift), bucketCount - 1);
+    }
+
+    static std::uint64_t upperBound(std::size_t bucket) {
+        if (bucket < 2 * subBuckets) {
+            return bucket;
+        }
+        std::size_t shift = bucket / subBuckets - 1;
+        return ((bucket % subBuckets + subBuckets + 1) << shift) - 1;
+    }
+
+public:
+    void record(std::uint64_t nanoseconds) {
+        ++m_counts[bucket(nanoseconds)];
+        ++m_total;
+        m_max = std::max(m_max, nanoseconds);
+    }
+
+    void merge(const LatencyRecorder &other) {
+        for (std::size_t i = 0; i < bucketCount; ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    // Upper bound of the bucket holding the given fraction (0..1] of the samples.
+    std::uint64_t percentile(double fraction) const {
+        auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fraction * static_cast<double>(m_total)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucketCount; ++i) {
+            seen += m_counts[i];
+            if (seen >= target) {
+                return std::min(upperBound(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    std::uint64_t total() const {
+        return m_total;
+    }
+
+    std::uint64_t max() const {
+        return m_max;
+    }
+};
+
+enum class Operation {
+    Window,
+    Button,
+    TextEdit
+};
+
+constexpr std::string_view operationNames[] = {
+        "window create/destroy",
+        "button create/click/destroy",
+        "text edit create/setText/destroy",
+};
+
+struct OperationStats {
+    LatencyRecorder latency;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocatedBytes = 0;
+
+    void merge(const OperationStats &other) {
+        latency.merge(other.latency);
+        allocations += other.allocations;
+        allocatedBytes += other.allocatedBytes;
+    }
+};
+
+using LoadStats = std::array<OperationStats, std::size(operationNames)>;
+
+// Short titles fit the inline buffers of WindowTitle and TextEdit, long ones go to the heap.
+std::vector<std::string> make_titles(const LoadOptions &options, std::mt19937_64 &random) {
+    const std::string_view words = "Untitled document - project notes, draft report and meeting summary for review ";
+    std::uniform_int_distribution<std::size_t> shortLength(4, std::min<std::size_t>(WINDOW_TITLE_CAPACITY, 32));
+    std::uniform_int_distribution<std::size_t> longLength(std::max(WINDOW_TITLE_CAPACITY, TEXT_EDIT_CAPACITY) + 1,
+                                                          2 * words.size());
+    std::uniform_int_distribution<std::uint64_t> percent(0, 99);
+    std::vector<std::string> titles(1024);
+    for (std::string &title: titles) {
+        std::size_t length = percent(random) < options.longTitlePercent ? longLength(random) : shortLength(random);
+        while (title.size() < length) {
+            title.append(words.substr(0, std::min(words.size(), length - title.size())));
+        }
+    }
+    return titles;
+}
+
+// Products a worker keeps alive; assigning a slot destroys the product created `live` operations earlier.
+template<typename Product>
+class LiveRing {
+    std::vector<Product> m_slots;
+    std::size_t m_next = 0;
+
+public:
+    explicit LiveRing(std::size_t size) : m_slots(size) {
+    }
+
+    void replace(Product product) {
+        m_slots[m_next] = std::move(product);
+        m_next = m_next + 1 == m_slots.size() ? 0 : m_next + 1;
+    }
+};
+
+void run_worker(const LoadOptions &options, std::uint64_t index, std::latch &start, LoadStats &stats) {
+    std::mt19937_64 random(options.seed + index);
+    const std::vector<std::string> titles = make_titles(options, random);
+    std::uniform_int_distribution<std::size_t> titleIndex(0, titles.size() - 1);
+    std::uniform_int_distribution<std::uint64_t> percent(0, 99);
+    std::discrete_distribution<int> operation({
+            static_cast<double>(options.windowWeight),
+            static_cast<double>(options.buttonWeight),
+            static_cast<double>(options.textEditWeight),
+    });
+
+    WindowCreationManager manager;
+    WindowsWindowBuilder windowsBuilder;
+    MacOSWindowBuilder macosBuilder;
+    WindowApplication *windowsApplication = WindowApplicationRegistry::instance().find(OS::Windows);
+    WindowApplication *macosApplication = WindowApplicationRegistry::instance().find(OS::MacOS);
+    LiveRing<WindowPtr<WindowsWindow>> windowsWindows(options.live);
+    LiveRing<WindowPtr<MacOSWindow>> macosWindows(options.live);
+    LiveRing<std::unique_ptr<Button>> buttons(options.live);
+    LiveRing<std::unique_ptr<TextEdit>> textEdits(options.live);
+
+    start.arrive_and_wait();
+    for (std::uint64_t i = 0; i < options.operations; ++i) {
+        auto kind = static_cast<Operation>(operation(random));
+        bool macos = percent(random) < options.macosPercent;
+        std::string_view title = titles[titleIndex(random)];
+
+        AllocationCounter allocations;
+        auto begin = std::chrono::steady_clock::now();
+        switch (kind) {
+            case Operation::Window:
+                if (macos) {
+                    manager.setBuilder(&macosBuilder);
+                    manager.createWindowWithTitle(title);
+                    macosWindows.replace(macosBuilder.getWindow());
+                } else {
+                    manager.setBuilder(&windowsBuilder);
+                    manager.createWindowWithTitle(title);
+                    windowsWindows.replace(windowsBuilder.getWindow());
+                }
+                break;
+            case Operation::Button: {
+                std::unique_ptr<Button> button((macos ? macosApplication : windowsApplication)->createButton());
+                button->buttonClick();
+                buttons.replace(std::move(button));
+                break;
+            }
+            case Operation::TextEdit: {
+                std::unique_ptr<TextEdit> textEdit((macos ? macosApplication : windowsApplication)->createTextEdit());
+                textEdit->setText(title);
+                outputSink().writeLine("Text edit have text -> ", textEdit->getText());
+                textEdits.replace(std::move(textEdit));
+                break;
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+
+        OperationStats &operationStats = stats[static_cast<std::size_t>(kind)];
+        operationStats.latency.record(static_cast<std::uint64_t>(elapsed));
+        operationStats.allocations += allocations.allocations();
+        operationStats.allocatedBytes += allocations.bytes();
+    }
+}
+
+// In KiB; Linux reports ru_maxrss in kilobytes.
+long peak_rss() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void report(const LoadOptions &options, const LoadStats &stats, double seconds, long rssBefore) {
+    std::uint64_t operations = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocatedBytes = 0;
+    LatencyRecorder latency;
+    for (const OperationStats &operationStats: stats) {
+        operations += operationStats.latency.total();
+        allocations += operationStats.allocations;
+        allocatedBytes += operationStats.allocatedBytes;
+        latency.merge(operationStats.latency);
+    }
+
+    auto print = [](std::string_view name, const LatencyRecorder &latency, std::uint64_t allocations,
+                    std::uint64_t allocatedBytes) {
+        auto count = static_cast<double>(std::max<std::uint64_t>(latency.total(), 1));
+        std::cout << name << ": " << latency.total() << " operations, p50 " << latency.percentile(0.5)
+                  << " ns, p99 " << latency.percentile(0.99) << " ns, p999 " << latency.percentile(0.999)
+                  << " ns, max " << latency.max() << " ns, " << static_cast<double>(allocations) / count
+                  << " allocations and " << static_cast<double>(allocatedBytes) / count << " bytes per operation\n";
+    };
+
+    std::cout << "load_test: " << options.threads << " threads x " << options.operations << " operations, "
+              << options.macosPercent << "% MacOS, " << options.longTitlePercent << "% long titles, mix "
+              << options.windowWeight << ":" << options.buttonWeight << ":" << options.textEditWeight << ", "
+              << options.live << " live products per kind, seed " << options.seed << "\n";
+    std::cout << "throughput: " << static_cast<double>(operations) / seconds << " operations/s (" << operations
+              << " in " << seconds << " s)\n";
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        print(operationNames[i], stats[i].latency, stats[i].allocations, stats[i].allocatedBytes);
+    }
+    print("all operations", latency, allocations, allocatedBytes);
+    std::cout << "allocations: " << allocations << " (" << allocatedBytes << " bytes)\n";
+    std::cout << "peak RSS: " << peak_rss() << " KiB (" << rssBefore << " KiB before the workers started)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    LoadOptions options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "usage: " << (argc > 0 ? argv[0] : "load_test")
+                  << " [--threads=N] [--operations=N] [--live=N] [--macos_percent=0..100]"
+                     " [--long_title_percent=0..100] [--window_weight=N] [--button_weight=N]"
+                     " [--text_edit_weight=N] [--seed=N]" << std::endl;
+        return 2;
+    }
+
+    NullOutputSink sink;
+    setOutputSink(&sink);
+    std::vector<LoadStats> stats(options.threads);
+    std::latch start(static_cast<std::ptrdiff_t>(options.threads + 1));
+    long rssBefore = peak_rss();
+
+    std::vector<std::thread> workers;
+    for (std::uint64_t i = 0; i < options.threads; ++i) {
+        workers.emplace_back(run_worker, std::cref(options), i, std::ref(start), std::ref(stats[i]));
+    }
+    start.arrive_and_wait();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    setOutputSink(nullptr);
+
+    LoadStats total;
+    for (const LoadStats &threadStats: stats) {
+        for (std::size_t i = 0; i < total.size(); ++i) {
+            total[i].merge(threadStats[i]);
+        }
+    }
+    report(options, total, elapsed.count(), rssBefore);
+    return 0;
+}